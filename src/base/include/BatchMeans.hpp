@@ -0,0 +1,101 @@
+// BatchMeans.hpp
+// standard error of a correlated time series by batch means
+//
+// author: sungcheolkim @ IBM
+// date: 20261018 - initial version (batch doubling)
+//
+// samples are summed into batches of size b. when all maxBatches_ batches
+// are full, neighbours are merged and b doubles, so memory is fixed and the
+// batches grow with the run until they are longer than the correlation time
+// of the series. the standard error is the spread of batch means over
+// sqrt(batches); lag1() of the batch means tells if batches are still too
+// short (near 0 when they are independent).
+
+#ifndef BATCHMEANS_H
+#define BATCHMEANS_H
+
+#include <math.h>
+#include <vector>
+
+using namespace std;
+
+class BatchMeans {
+
+public:
+  // member functions
+  void add(double x);
+  double mean();
+  double stdError();
+  double lag1();
+
+  // constructor
+  BatchMeans(size_t maxBatches=64): maxBatches_(maxBatches), batchSize_(1), count_(0), sum_(0.0), partSum_(0.0), part_(0) { }
+  virtual ~BatchMeans() { };
+
+  // inline functions
+  inline size_t count() { return count_; }
+  inline size_t batches() { return batch_.size(); }
+  inline size_t batchSize() { return batchSize_; }
+  inline double relError() { double m = mean(); return (m != 0.0) ? stdError()/fabs(m) : HUGE_VAL; }
+
+private:
+  size_t maxBatches_;
+  size_t batchSize_;
+  size_t count_;
+  double sum_;
+  double partSum_;              // open batch
+  size_t part_;
+  vector<double> batch_;        // sums of full batches
+};
+
+void BatchMeans::add(double x) {
+  count_++;
+  sum_ += x;
+  partSum_ += x;
+  if (++part_ < batchSize_) return;
+
+  batch_.push_back(partSum_);
+  partSum_ = 0.0;
+  part_ = 0;
+
+  if (batch_.size() == maxBatches_) {
+    for (size_t i=0; i < maxBatches_/2; ++i) batch_[i] = batch_[2*i] + batch_[2*i+1];
+    batch_.resize(maxBatches_/2);
+    batchSize_ *= 2;
+  }
+}
+
+double BatchMeans::mean() {
+  return (count_ > 0) ? sum_/(double)count_ : 0.0;
+}
+
+double BatchMeans::stdError() {
+  size_t n = batch_.size();
+  if (n < 2) return HUGE_VAL;
+
+  double m = 0.0;
+  for (auto s : batch_) m += s;
+  m /= (double)(n*batchSize_);
+  double var = 0.0;
+  for (auto s : batch_) { double d = s/(double)batchSize_ - m; var += d*d; }
+  return sqrt(var/(double)(n-1)/(double)n);
+}
+
+double BatchMeans::lag1() {
+  size_t n = batch_.size();
+  if (n < 3) return 1.0;
+
+  double m = 0.0;
+  for (auto s : batch_) m += s;
+  m /= (double)n;
+  double c0 = 0.0, c1 = 0.0;
+  for (size_t i=0; i < n; ++i) {
+    c0 += (batch_[i] - m)*(batch_[i] - m);
+    if (i > 0) c1 += (batch_[i] - m)*(batch_[i-1] - m);
+  }
+  return (c0 > 0.0) ? c1/c0 : 0.0;
+}
+
+#endif
+
+// vim:foldmethod=syntax:foldlevel=0
@@ -0,0 +1,95 @@
+// CellList.hpp
+// uniform grid of walker indices for neighbor search
+//
+// author: sungcheolkim @ IBM
+// date: 20261018 - initial version (counting sort build)
+// date: 20261019 - cell geometry from UniformGrid
+//
+// items of cell c are items_[start_[c] .. start_[c+1]). build is O(N) and
+// does not allocate once the arrays have grown to the cloud size.
+
+#ifndef CELLLIST_H
+#define CELLLIST_H
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <math.h>
+#include "Vec3.hpp"
+#include "Walker.h"
+#include "UniformGrid.hpp"
+
+using namespace std;
+
+class CellList : public UniformGrid {
+
+public:
+  // member functions
+  void setGrid(Vec3<double> lo, Vec3<double> hi, double h, size_t n);
+  void build(vector<Walker*>& wlist);
+  void neighborCells(Vec3<double> p, vector<size_t>& cells);
+  void boxCells(Vec3<double> lo, Vec3<double> hi, vector<size_t>& cells);
+
+  // constructor
+  CellList(): UniformGrid(1.0) { }
+  virtual ~CellList() { };
+
+  // inline functions
+  inline uint32_t start(size_t c) { return start_[c]; }
+  inline uint32_t end(size_t c) { return start_[c+1]; }
+  inline uint32_t item(uint32_t k) { return items_[k]; }
+
+private:
+  vector<uint32_t> start_;
+  vector<uint32_t> items_;
+  vector<uint32_t> cell_;
+};
+
+void CellList::setGrid(Vec3<double> lo, Vec3<double> hi, double h, size_t n) {
+  UniformGrid::setGrid(lo, hi, h, n);
+  start_.assign(cellNumber()+1, 0);
+}
+
+void CellList::build(vector<Walker*>& wlist) {
+  fill(start_.begin(), start_.end(), 0);
+  cell_.resize(wlist.size());
+  items_.resize(wlist.size());
+
+  for (size_t i=0; i < wlist.size(); ++i) {
+    cell_[i] = cellOf(wlist[i]->position());
+    start_[cell_[i]+1]++;
+  }
+  for (size_t c=0; c+1 < start_.size(); ++c) start_[c+1] += start_[c];
+  for (size_t i=0; i < wlist.size(); ++i)
+    items_[start_[cell_[i]]++] = i;
+  // fill pass shifted start_ by one cell
+  for (size_t c=start_.size()-1; c > 0; --c) start_[c] = start_[c-1];
+  start_[0] = 0;
+}
+
+void CellList::neighborCells(Vec3<double> p, vector<size_t>& cells) {
+  cells.clear();
+  long ix = clamp((p.X()-lo_.X())/h_, nx_);
+  long iy = clamp((p.Y()-lo_.Y())/h_, ny_);
+  long iz = clamp((p.Z()-lo_.Z())/h_, nz_);
+  for (long kz=max(iz-1, 0L); kz <= min(iz+1, nz_-1); ++kz)
+    for (long ky=max(iy-1, 0L); ky <= min(iy+1, ny_-1); ++ky)
+      for (long kx=max(ix-1, 0L); kx <= min(ix+1, nx_-1); ++kx)
+        cells.push_back((kz*ny_ + ky)*nx_ + kx);
+}
+
+void CellList::boxCells(Vec3<double> lo, Vec3<double> hi, vector<size_t>& cells) {
+  // all cells overlapping box [lo, hi]
+  cells.clear();
+  long x0 = clamp((lo.X()-lo_.X())/h_, nx_), x1 = clamp((hi.X()-lo_.X())/h_, nx_);
+  long y0 = clamp((lo.Y()-lo_.Y())/h_, ny_), y1 = clamp((hi.Y()-lo_.Y())/h_, ny_);
+  long z0 = clamp((lo.Z()-lo_.Z())/h_, nz_), z1 = clamp((hi.Z()-lo_.Z())/h_, nz_);
+  for (long kz=z0; kz <= z1; ++kz)
+    for (long ky=y0; ky <= y1; ++ky)
+      for (long kx=x0; kx <= x1; ++kx)
+        cells.push_back((kz*ny_ + ky)*nx_ + kx);
+}
+
+#endif
+
+// vim:foldmethod=syntax:foldlevel=0
@@ -5,6 +5,20 @@
 // date: 20160202
 // date: 2017/09/06 - generalize for multiple clouds
 // date: 2017/09/12 - using abstract class
+// date: 20261018 - walker records and statistics in cloud pools
+// date: 20261018 - columnar trajectory output (compressed)
+// date: 20261018 - output selectors (tids, fraction, region, hit)
+// date: 20261018 - density maps
+// date: 20261018 - rate statistics for convergence stop
+// date: 20261018 - check and output counters
+// date: 20261018 - location grid with segment traversal
+// date: 20261018 - bound walkers released by step
+// date: 20261018 - walker records in space filling curve order
+// date: 20261018 - walker pool, concurrent location queries
+// date: 20261018 - statistical weights, split walkers
+// date: 20261019 - capped rejection of random positions in obstacles
+// date: 20261019 - no pid list, partition kept on the walker
+// date: 20261019 - reorder clones records instead of copying bytes
 
 #ifndef CLOUD_H
 #define CLOUD_H
@@ -18,8 +32,16 @@
 #include "Log.hpp"
 #include "ParameterReader.h"
 #include "Surfaces.hpp"
+#include "Obstacles.hpp"
+#include "Philox.hpp"
 #include "Walker.h"
 #include "WalkerBase.h"
+#include "WalkerPool.hpp"
+#include "Trajectory.hpp"
+#include "DensityMap.hpp"
+#include "BatchMeans.hpp"
+#include "LocationGrid.hpp"
+#include "TaskPool.hpp"
 
 using namespace std;
 
@@ -34,26 +56,67 @@ public:
   virtual void setSubstrateCloud(Cloud* sc) = 0;
   virtual double concentration() = 0;
   virtual double cellConcentration() = 0;
+  virtual double r() = 0;
+  virtual Walker* newWalker(Vec3<double> p) = 0;
+  // product rate samples - nullptr for clouds without reactions
+  virtual BatchMeans* rateStatistics() { return nullptr; }
+  // walker indices changed by reorderWalkers
+  virtual void walkersReordered() { }
+  virtual ~Cloud() {
+    if (traj_ != nullptr) delete traj_;
+    if (map_ != nullptr) delete map_;
+  }
 
   // member functions
   void addWalker(Walker* w);
   void removeWalker(size_t tid);
+  Walker* splitWalker(Walker* w);
+  void shiftWalker(Walker* w, Vec3<double> dr);
+  WalkerStats* statsOf(Walker* w);
+  size_t calPID(Vec3<double> p);
+  void setPIDRange(double x1, double x2, double x3, double y1, double z1);
   unsigned int size() { return wlist_.size(); }
+  vector<Walker*>& wlist() { return wlist_; }
+  size_t updateCount() { return updateCount_; }
+  size_t moveCount() { return moveCount_; }
+  uint64_t checkCount() { return checkCount_; }
+  uint64_t bytesWritten() { return bytesWritten_; }
+  WalkerPool& pool() { return pool_; }
+  // block backing of walkers and statistics, before injection
+  void memoryPolicy(MemoryPolicy* mp) { pool_.policy(mp); statsPool_.policy(mp); }
   Walker* operator[](int i) {
     //if (i<0 || size()<i) throw out_of_range{"Cloud::operator[] - "+to_string(i)+" size: "+to_string(size())};
     return wlist_[i];
   };
 
   void writeWalker();
-  Vec3<double> getStep(double dt);
+  void writeLine(ostream& file, Walker* w);
+  double durationOf(Walker* w);
+  void reorderWalkers(size_t step);
+  void setSaveFilter(ParameterReader& pr);
+  bool saveSelected(Walker* w);
+  void setDensityMap(ParameterReader& pr);
+  void sampleMap();
+  void writeMap();
+  Vec3<double> getStep(double dt, gsl_rng* r);
+  inline Vec3<double> getStep(double dt) { return getStep(dt, rs_); }
   void writeHeader(string fn);
-  set<size_t> getLocationList(Vec3<double> p, Vec3<double> dr);
+  void prepareLocationList(double sight);
+  void getLocationList(Vec3<double> p, Vec3<double> dr, double sight, vector<size_t>& list);
+  // prepared grid, buffers of the caller - for concurrent queries
+  inline void getLocationList(Vec3<double> p, Vec3<double> dr, vector<size_t>& list, vector<size_t>& cells) {
+    grid_.segmentItems(p, dr, list, cells);
+  }
+  Vec3<double> calRandomPosition(SurfaceTypeClass sc);
+  inline Vec3<double> calRandomPosition() { return calRandomPosition(sf_->stype()); }
 
   // inline functions
   string cloudID() { return cloudID_; }
   void cloudID(string cID) { cloudID_ = cID; }
   string savefilename() { return savefilename_; }
   void savefilename(string fname) { savefilename_ = fname; }
+  bool columnar() { return columnar_; }
+  void columnar(bool c) { columnar_ = c; }
   string infoString() { return infoString_; }
   void infoString(string s) { infoString_ = s; }
   gsl_rng* rs() { return rs_; }
@@ -70,27 +133,102 @@ public:
   void sf(Surfaces* sf) { sf_ = sf; }
   double dt() { return dt_; }
   void dt(double t) { dt_ = t; }
+  DensityMap* densityMap() { return map_; }
+  size_t reorderCycle() { return reorderCycle_; }
+  void reorderCycle(size_t k) { reorderCycle_ = k; }
+  // tid in trajectory files - kept when records are reordered
+  inline size_t outputTid(Walker* w) { return label_.empty() ? w->tid() : label_[w->tid()]; }
+  // statistical weight of walker (1 until weights are on)
+  inline bool weighted() { return !weight_.empty(); }
+  inline void weighted(bool on) { weight_.assign(on ? wlist_.size() : 0, 1.0); }
+  inline double weight(Walker* w) { return weight_.empty() ? 1.0 : weight_[w->tid()]; }
+  inline void weight(Walker* w, double x) { weight_[w->tid()] = x; }
+  Obstacles* obstacles() { return obs_; }
+  void obstacles(Obstacles* o) { obs_ = o; }
+  bool isStatic() { return static_; }
+  void isStatic(bool s) { static_ = s; }
+  double time() { return time_; }
+  void time(double t) { time_ = t; }
+  size_t step() { return step_; }
+  void step(size_t s) { step_ = s; }
+  // keyed generator: stream of walker in this step (same after reorder)
+  inline void selectStream(Walker* w, gsl_rng* r) {
+    if (r->type == gsl_rng_philox) philox_stream(r, (uint32_t)outputTid(w), (uint32_t)step_);
+  }
+  inline void selectStream(Walker* w) { selectStream(w, rs_); }
+  // threads for walkers of one cloud (nullptr: one after another)
+  TaskPool* walkerPool() { return walkerPool_; }
+  void walkerPool(TaskPool* p, size_t grain) { walkerPool_ = p; walkerGrain_ = grain; }
 
 protected:
   // cloud related information
   vector<Walker*> wlist_;
-  Surfaces* sf_;
+  // walkers and their statistics - freed by blocks with the cloud
+  WalkerPool pool_{sizeof(Walker), alignof(Walker)};
+  WalkerPool statsPool_{sizeof(WalkerStats), alignof(WalkerStats)};
+  Surfaces* sf_ = nullptr;
+  Obstacles* obs_ = nullptr;
 
   string cloudID_;
   string savefilename_;
+  bool columnar_ = false;             // .ptc instead of text .pt
+  TrajectoryWriter* traj_ = nullptr;  // opened with the first frame
+  double saveResolution_ = 0.0;       // > 0: compressed positions [um]
+  size_t saveChunk_ = 64;             // frames per key frame
+
+  // output selectors - all must hold
+  bool saveFilter_ = false;
+  vector<pair<size_t, size_t>> saveTids_;   // tid ranges
+  double saveFraction_ = 1.0;               // fixed subset by tid hash
+  bool saveRegionOn_ = false;
+  SurfaceTypeClass saveRegion_ = SurfaceTypeClass::volume;
+  bool saveHitOnly_ = false;                // substrate hit since last frame
+  vector<uint32_t> lastHit_;                // substrate hits by tid at last frame
+
+  // occupancy, reaction and wall hit histograms - written every info cycle
+  DensityMap* map_ = nullptr;
+  size_t mapCycle_ = 1;
+  string mapfilename_;
   string walkerType_;
   string surfaceShape_;
   string infoString_;
 
   gsl_rng* rs_;
+  TaskPool* walkerPool_ = nullptr;
+  size_t walkerGrain_ = 16;
 
   // particle related information
   double D_;
   double alpha_;
   double dt_;
 
-  // virtual cloud for particle particle interaction
-  vector<set<size_t>> pidList_;
+  // walkers by cell for segment queries - built on first query
+  LocationGrid grid_;
+  // bound walkers: step of release by tid (0 - moving), duration left at release
+  vector<uint64_t> wake_;
+  // records sorted by Morton key of their cell every reorderCycle_ steps
+  size_t reorderCycle_ = 0;
+  vector<uint32_t> label_;            // output tid by tid, empty before first reorder
+  uint32_t nextLabel_ = 0;
+  vector<double> weight_;             // weight by tid, empty without resampling
+  vector<pair<uint64_t, uint32_t>> order_;
+  vector<char> records_;              // reusable buffer for records
+  double px1_ = 0.0, px2_ = 0.0, px3_ = 0.0;
+  double py1_ = 0.0;
+  double pz1_ = 0.0;
+  // number of add/remove - walker indices change
+  size_t updateCount_ = 0;
+  // number of shifts - positions change
+  size_t moveCount_ = 0;
+  // throughput counters - distance tests and output bytes
+  uint64_t checkCount_ = 0;
+  uint64_t bytesWritten_ = 0;
+
+  // walker age is the simulator time; static cloud: not moved, written when changed
+  bool static_ = false;
+  double time_ = 0.0;
+  size_t step_ = 0;
+  size_t writeCount_ = (size_t)-1;
 };
 
 void Cloud::writeHeader(string fn) {
@@ -103,7 +241,20 @@ void Cloud::writeHeader(string fn) {
 
 void Cloud::addWalker(Walker* w) {
   wlist_.push_back(w);
-  pidList_[w->pid()].insert(w->tid());
+  if (grid_.on()) grid_.insert(w->tid(), w->position());
+  if (!label_.empty()) label_.push_back(nextLabel_++);
+  if (!weight_.empty()) weight_.push_back(1.0);
+  updateCount_++;
+}
+
+Walker* Cloud::splitWalker(Walker* w) {
+  // copy of a moving walker in a new slot with its own statistics;
+  // the caller sets the weights of both
+  Walker* c = w->clone(pool_.allocate());
+  if (w->hasStats()) *statsOf(c) = *w->stats();
+  c->tid(wlist_.size());
+  addWalker(c);
+  return c;
 }
 
 void Cloud::removeWalker(size_t tid) {
@@ -112,21 +263,218 @@ void Cloud::removeWalker(size_t tid) {
   //  return;
   // }
 
-  std::swap(wlist_[tid], wlist_.back());
+  // last walker takes over the removed index (tid == index in wlist_)
+  Walker* w = wlist_[tid];
+  if (grid_.on()) {
+    grid_.erase(tid);
+    if (tid != wlist_.size()-1) grid_.renumber(wlist_.size()-1, tid);
+  }
+  if (tid != wlist_.size()-1) {
+    Walker* b = wlist_.back();
+    b->tid(tid);
+    wlist_[tid] = b;
+  }
   wlist_.pop_back();
+  // hit count and release step follow the moved walker
+  if (lastHit_.size() > wlist_.size()) {
+    if (tid < wlist_.size()) lastHit_[tid] = lastHit_[wlist_.size()];
+    lastHit_.resize(wlist_.size());
+  }
+  if (wake_.size() > wlist_.size()) {
+    if (tid < wlist_.size()) wake_[tid] = wake_[wlist_.size()];
+    wake_.resize(wlist_.size());
+  }
+  if (!label_.empty()) {
+    label_[tid] = label_.back();
+    label_.pop_back();
+  }
+  if (!weight_.empty()) {
+    weight_[tid] = weight_.back();
+    weight_.pop_back();
+  }
+  // slots are reused by new walkers
+  if (w->hasStats()) statsPool_.release(w->stats());
+  w->~Walker();
+  pool_.release(w);
+  updateCount_++;
+}
+
+void Cloud::shiftWalker(Walker* w, Vec3<double> dr) {
+  // move walker and keep its partition for the trajectory
+  Vec3<double> p = w->position();
+  w->step(dr);
+  if ((sizeof(real_t) < sizeof(double)) and !sf_->isInside(w->position())) {
+    // rounding to float crossed the wall: round towards the old position
+    Vec3<real_t> q(p + dr), o(p);
+    for (int i=0; (i < 4) and !sf_->isInside(Vec3<double>(q)); ++i)
+      q.setXYZ(nextafter(q.X(), o.X()), nextafter(q.Y(), o.Y()), nextafter(q.Z(), o.Z()));
+    w->position(sf_->isInside(Vec3<double>(q)) ? Vec3<double>(q) : p);
+  }
+  if (grid_.on()) grid_.move(w->tid(), w->position());
+  w->pid(calPID(w->position()));
+  moveCount_++;
+}
+
+WalkerStats* Cloud::statsOf(Walker* w) {
+  // attach statistics on first use
+  if (!w->hasStats()) w->stats(new (statsPool_.allocate()) WalkerStats);
+  return w->stats();
 }
 
 void Cloud::writeWalker() {
-  for(auto w : wlist_) w->write(savefilename_);
+  if (static_) {
+    // static frame - only again after relocation or removal
+    if (writeCount_ == updateCount_ + moveCount_) return;
+    writeCount_ = updateCount_ + moveCount_;
+  }
+  if (columnar_) {
+    if (traj_ == nullptr) traj_ = new TrajectoryWriter{savefilename_, cloudID_, r(), saveResolution_, saveChunk_};
+    uint64_t start = traj_->bytes();
+    traj_->beginFrame(time_, step_);
+    for(auto w : wlist_)
+      if (!saveFilter_ or saveSelected(w))
+        traj_->add(w->position(), durationOf(w), outputTid(w), w->pid());
+    traj_->endFrame();
+    bytesWritten_ += traj_->bytes() - start;
+    return;
+  }
+
+  // one open per frame - time and radius are same for all walkers
+  ofstream file;
+  file.open(savefilename_.c_str(), ios::out|ios::app);
+  auto start = file.tellp();
+  for(auto w : wlist_)
+    if (!saveFilter_ or saveSelected(w)) writeLine(file, w);
+  bytesWritten_ += (uint64_t)(file.tellp() - start);
+  file.close();
 }
 
-Vec3<double> Cloud::getStep(double dt) {
+void Cloud::writeLine(ostream& file, Walker* w) {
+  // columns of Walker::write with current duration and output tid
+  Vec3<double> p = w->position();
+  file << time_ << " " << p.X() << " " << p.Y() << " " << p.Z() << " " << r()
+       << " " << durationOf(w) << " " << outputTid(w) << " 0\n";
+}
+
+double Cloud::durationOf(Walker* w) {
+  // bound walkers are not visited until release: dt per step until then
+  size_t tid = w->tid();
+  if ((tid >= wake_.size()) or (wake_[tid] == 0)) return w->duration();
+  return w->duration() + (double)(wake_[tid] - 1 - step_)*dt_;
+}
+
+void Cloud::setSaveFilter(ParameterReader& pr) {
+  // tid list: (0-99, 200, 300-310)
+  if (pr.checkName(cloudID_+" Save Tids"))
+    for (auto s : pr.arrayRead(cloudID_+" Save Tids", "(0)")) {
+      size_t dash = s.find("-");
+      size_t a = stoul(s.substr(0, dash));
+      size_t b = (dash == string::npos) ? a : stoul(s.substr(dash+1));
+      saveTids_.push_back(make_pair(a, b));
+    }
+  saveFraction_ = pr.doubleRead(cloudID_+" Save Fraction", "1.0", false);
+  if (pr.checkName(cloudID_+" Save Region")) {
+    string res = pr.stringRead(cloudID_+" Save Region", "vol");
+    saveRegionOn_ = true;
+    if (res.find("sur") != string::npos) saveRegion_ = SurfaceTypeClass::surface;
+    else if (res.find("disk") != string::npos) saveRegion_ = SurfaceTypeClass::disk;
+    else if (res.find("ring") != string::npos) saveRegion_ = SurfaceTypeClass::ring;
+    else if (res.find("vol") != string::npos) saveRegion_ = SurfaceTypeClass::volume;
+    else {
+      cerr << "... Save Region: [vol|sur|disk|ring] " << res << endl;
+      exit(1);
+    }
+  }
+  saveHitOnly_ = pr.boolRead(cloudID_+" Save Hit Only", "False", false);
+
+  saveFilter_ = !saveTids_.empty() or (saveFraction_ < 1.0) or saveRegionOn_ or saveHitOnly_;
+  if (saveFilter_)
+    cout << "... save selected walkers of Cloud(" << cloudID_ << ")" << endl;
+}
+
+bool Cloud::saveSelected(Walker* w) {
+  size_t tid = w->tid();
+
+  // hit window ends with this frame - update for every walker
+  if (saveHitOnly_) {
+    if (lastHit_.size() < wlist_.size()) lastHit_.resize(wlist_.size(), 0);
+    uint32_t hit = (uint32_t)w->substrateHit();
+    bool hitNow = (hit != lastHit_[tid]);
+    lastHit_[tid] = hit;
+    if (!hitNow) return false;
+  }
+
+  size_t oid = outputTid(w);
+  if (!saveTids_.empty()) {
+    bool in = false;
+    for (auto& t : saveTids_) if ((oid >= t.first) and (oid <= t.second)) { in = true; break; }
+    if (!in) return false;
+  }
+
+  // same walkers in every frame
+  if (saveFraction_ < 1.0) {
+    uint64_t h = (uint64_t)(oid + 1)*0x9E3779B97F4A7C15ull;
+    h ^= h >> 31;
+    if (ldexp((double)(h >> 11), -53) >= saveFraction_) return false;
+  }
+
+  if (saveRegionOn_ and !sf_->isInsideType(w->position(), saveRegion_)) return false;
+
+  return true;
+}
+
+void Cloud::setDensityMap(ParameterReader& pr) {
+  if (!pr.boolRead(cloudID_+" Density Map", "False", false)) return;
+
+  // grid over the surface bounding box
+  double h = pr.doubleRead(cloudID_+" Map Voxel Size", "100")/1000.0;   // [nm] -> [um]
+  mapCycle_ = max(1, pr.intRead(cloudID_+" Map Cycle", "1"));
+  map_ = new DensityMap;
+  map_->setGrid(sf_->minDimension(), sf_->maxDimension(), h);
+  mapfilename_ = infoString_ + "_" + cloudID_ + "_map.bin";
+  cout << "... density map: " << gre << map_->size() << def << " voxels -> " << mapfilename_ << endl;
+}
+
+void Cloud::sampleMap() {
+  if ((map_ == nullptr) or (step_%mapCycle_ != 0)) return;
+  for (auto w : wlist_) map_->add(mapOccupancy, w->position());
+  map_->addSample();
+}
+
+void Cloud::writeMap() {
+  if (map_ != nullptr) bytesWritten_ += map_->write(mapfilename_, time_);
+}
+
+size_t Cloud::calPID(Vec3<double> p) {
+  size_t xind = 0;
+  size_t yind = 0;
+  size_t zind = 0;
+
+  // pid range = (0, 15)
+  if (p.X() >= px3_) { xind = 0; }
+  else if (p.X() >= px2_) { xind = 1; }
+  else if (p.X() >= px1_) { xind = 2; }
+  else { xind = 3; }
+
+  if (p.Y() < py1_) yind = 1;
+  if (p.Z() < pz1_) zind = 1;
+
+  return xind + 4*yind + 8*zind;
+}
+
+void Cloud::setPIDRange(double x1, double x2, double x3, double y1, double z1) {
+  px1_ = x1; px2_ = x2; px3_ = x3;
+  py1_ = y1;
+  pz1_ = z1;
+}
+
+Vec3<double> Cloud::getStep(double dt, gsl_rng* r) {
   Vec3<double> dr{0,0,0};
   if (D_ == 0.0)
     return dr;
 
   /* original method - high peak near 0
-  float random_step = sqrt(2.0*D_*dt)*gsl_ran_levy(rs_, 1.0, alpha_);
+  double random_step = sqrt(2.0*D_*dt)*gsl_ran_levy(rs_, 1.0, alpha_);
 
   double ux, uy, uz;
   gsl_ran_dir_3d(rs_, &ux, &uy, &uz);
@@ -135,46 +483,120 @@ Vec3<double> Cloud::getStep(double dt) {
   */
 
   // levy distribution becomes gaussian distribution with sigma=\sqrt{2}*c
-  double ux = sqrt(D_*dt)*gsl_ran_levy(rs_, 1.0, alpha_);
-  double uy = sqrt(D_*dt)*gsl_ran_levy(rs_, 1.0, alpha_);
-  double uz = sqrt(D_*dt)*gsl_ran_levy(rs_, 1.0, alpha_);
+  double ux = sqrt(D_*dt)*gsl_ran_levy(r, 1.0, alpha_);
+  double uy = sqrt(D_*dt)*gsl_ran_levy(r, 1.0, alpha_);
+  double uz = sqrt(D_*dt)*gsl_ran_levy(r, 1.0, alpha_);
 
   dr.set(ux, uy, uz);
 
   return dr;
 }
 
-set<size_t> Cloud::getLocationList(Vec3<double> p, Vec3<double> dr) {
-  size_t initial_pid = wlist_[0]->calPID(p);
-  size_t final_pid = wlist_[0]->calPID(p+dr);
+Vec3<double> Cloud::calRandomPosition(SurfaceTypeClass sc) {
+  // random position inside surfaces and outside of obstacles - injection and
+  // relocation both come here, so a crowding that leaves no room stops the run
+  const size_t maxTries = 100000;
+  Vec3<double> p;
+  size_t tries = 0;
+  do {
+    if (++tries > maxTries) {
+      cerr << "... no free position for " << cloudID_ << " (radius " << r()*1000.0 << " [nm]) after "
+           << maxTries << " tries, obstacle volume fraction " << obs_->volumeFraction() << endl;
+      exit(1);
+    }
+    p = sf_->calRandomPosition(rs_, sc);
+  } while ((obs_ != nullptr) and obs_->isInside(p, r()));
+
+  return p;
+}
 
-  // check in same partition
-  if (initial_pid == final_pid)
-    return pidList_[final_pid];
+inline uint64_t mortonSpread(uint64_t v) {
+  // 21 bits to every third bit
+  v &= 0x1fffff;
+  v = (v | v << 32) & 0x1f00000000ffffull;
+  v = (v | v << 16) & 0x1f0000ff0000ffull;
+  v = (v | v << 8) & 0x100f00f00f00f00full;
+  v = (v | v << 4) & 0x10c30c30c30c30c3ull;
+  v = (v | v << 2) & 0x1249249249249249ull;
+  return v;
+}
 
-  set<size_t> l{initial_pid, final_pid};
+void Cloud::reorderWalkers(size_t step) {
+  size_t n = wlist_.size();
+  if ((reorderCycle_ == 0) or (step%reorderCycle_ != 0) or (n < 2)) return;
+  if (label_.empty()) {
+    label_.resize(n);
+    for (size_t i=0; i < n; ++i) label_[i] = i;
+    nextLabel_ = n;
+  }
 
-  // find other partition in case of middle point is in different pid
-  size_t middle_pid = wlist_[0]->calPID(p+dr*0.5);
-  if (l.find(middle_pid) == l.end()) {
-    l.insert(middle_pid);
-    middle_pid = wlist_[0]->calPID(p+dr*0.25);
-    if (l.find(middle_pid) == l.end()) {
-      l.insert(middle_pid);
-      middle_pid = wlist_[0]->calPID(p+dr*0.75);
-      if (l.find(middle_pid) == l.end())
-        l.insert(middle_pid);
-    }
+  // key of cell: grid of substrate queries or about one walker per cell
+  Vec3<double> lo = sf_->minDimension();
+  Vec3<double> ext = sf_->maxDimension() - lo;
+  double h = grid_.on() ? grid_.h() : pow(ext.X()*ext.Y()*ext.Z()/(double)n, 1.0/3.0);
+  order_.resize(n);
+  for (size_t i=0; i < n; ++i) {
+    Vec3<double> p = (wlist_[i]->position() - lo)/h;
+    uint64_t x = (uint64_t)max(p.X(), 0.0), y = (uint64_t)max(p.Y(), 0.0), z = (uint64_t)max(p.Z(), 0.0);
+    order_[i] = make_pair(mortonSpread(x) | mortonSpread(y) << 1 | mortonSpread(z) << 2, (uint32_t)i);
   }
+  sort(order_.begin(), order_.end());
+  bool sorted = true;
+  for (size_t k=0; sorted and (k < n); ++k) sorted = (order_[k].second == k);
+  if (sorted) return;
+
+  // records of one cloud have one type (clones of the prototype): clone them
+  // in the new order into an aligned scratch area and back into the slots in
+  // address order, so index order is memory order. statistics stay attached
+  size_t sz = pool_.slotSize();
+  size_t al = alignof(Walker);
+  records_.resize(n*sz + al);
+  char* buf = records_.data() + (al - (uintptr_t)records_.data()%al)%al;
+  for (size_t k=0; k < n; ++k) {
+    Walker* w = wlist_[order_[k].second];
+    w->clone(buf + k*sz)->stats(w->stats());
+    w->~Walker();
+  }
+  sort(wlist_.begin(), wlist_.end());
+  for (size_t k=0; k < n; ++k) {
+    Walker* c = (Walker*)(buf + k*sz);
+    wlist_[k] = c->clone((void*)wlist_[k]);
+    wlist_[k]->stats(c->stats());
+    wlist_[k]->tid(k);
+    c->~Walker();
+  }
+
+  // arrays by tid follow the records
+  auto permute = [&](auto& v) {
+    if (v.size() < n) return;
+    auto old = v;
+    for (size_t k=0; k < n; ++k) v[k] = old[order_[k].second];
+  };
+  permute(label_);
+  permute(weight_);
+  permute(lastHit_);
+  permute(wake_);
+  if (grid_.on()) {
+    vector<uint32_t> newTid(n);
+    for (size_t k=0; k < n; ++k) newTid[order_[k].second] = k;
+    grid_.permute(newTid);
+  }
+  updateCount_++;
+  walkersReordered();
+}
 
-  // make new set for search
-  //cout << wlist_.size() << ")" << endl;
-  set<size_t> a;
-  for(auto pid : l)
-    for(auto element : pidList_[pid])
-      a.insert(element);
+void Cloud::prepareLocationList(double sight) {
+  // cells at least sight wide
+  if (!grid_.on() or (grid_.h() < sight)) {
+    grid_.setGrid(sf_->minDimension(), sf_->maxDimension(), sight, wlist_.size());
+    for (auto w : wlist_) grid_.insert(w->tid(), w->position());
+  }
+}
 
-  return a;
+void Cloud::getLocationList(Vec3<double> p, Vec3<double> dr, double sight, vector<size_t>& list) {
+  // candidates within sight of segment p -> p+dr
+  prepareLocationList(sight);
+  grid_.segmentItems(p, dr, list);
 }
 
 #endif
@@ -5,6 +5,13 @@
 // date: 20160202
 // date: 2017/09/06 - generalize for multiple clouds
 // date: 2017/09/29 - virtual cloud for particle particle interaction
+// date: 20261018 - walkers from cloud pool, cloud owns surfaces
+// date: 20261018 - save format (text, column, compressed), output selectors
+// date: 20261018 - density maps
+// date: 20261018 - reorder cycle
+// date: 20261018 - pool slot of the walker type
+// date: 20261019 - partition counts from walkers
+// date: 20261018 - injection streams keyed by walker
 //
 
 #ifndef CLOUDBASE_H
@@ -19,6 +26,7 @@
 #include "SurfacesSphere.hpp"
 #include "SurfacesBox.hpp"
 #include "SurfacesCell.hpp"
+#include "Obstacles.hpp"
 #include "Walker.h"
 #include "WalkerBase.h"
 #include "WalkerEnzyme.h"
@@ -35,11 +43,15 @@ public:
   virtual void moveWalker(double dt);
   virtual void info(Log* log_);
   virtual void setSubstrateCloud(Cloud* sc);
+  virtual Walker* newWalker(Vec3<double> p);
 
   // constructor
   CloudBase(ParameterReader& pr, string cID) :
     viscosity_(0.001),
-    temperature_(300.0) {
+    temperature_(300.0),
+    mass_(0.0),
+    obstacleHit_(0),
+    proto_(nullptr) {
     cout << blu << "[Cloud(" << cID << ")] is initialized." << def << endl;
 
     cloudID(cID);
@@ -51,21 +63,31 @@ public:
     else 
       infoString(tmp);
 
-    savefilename(infoString() + "_" + cID + ".pt");
+    // columnar trajectory with frame index (.ptc) or text (.pt)
+    string format = pr.stringRead("save Format", "Text");
+    columnar((format.find("Column") != string::npos) or (format.find("Compressed") != string::npos));
+    if (format.find("Compressed") != string::npos) {
+      saveResolution_ = pr.doubleRead("save Resolution", "0.1")/1000.0;   // [nm] -> [um]
+      saveChunk_ = pr.intRead("save Chunk", "64");
+    }
+    savefilename(infoString() + "_" + cID + (columnar() ? ".ptc" : ".pt"));
     alpha(pr.doubleRead(cID+" Alpha", "2.0"));
     surfaceShape(pr.stringRead(cID+" Surface Shape", "Sphere"));
     walkerType(pr.stringRead(cID+" Walker Type", "Base"));
     debug(pr.boolRead(cID+" Debug", "False"));
+    reorderCycle(pr.intRead(cID+" Reorder Cycle", "0", false));
     dt_ = pr.doubleRead("dt", "0.0001");
 
-    // initialize pid list
-    set<size_t> empty;
-    for(auto i=0; i < 16; i++) pidList_.push_back(empty);
-
-    writeHeader(savefilename());
+    if (!columnar()) writeHeader(savefilename());
+    setSaveFilter(pr);
     setProperties(pr);
+    setDensityMap(pr);                // grid from the surface
   }
-  virtual ~CloudBase() { };
+  virtual ~CloudBase() {
+    // walkers go with the pool blocks
+    if (proto_ != nullptr) delete proto_;
+    if (sf_ != nullptr) delete sf_;
+  };
 
   // inline functions
   inline double concentration() { return concentration_; }
@@ -74,6 +96,8 @@ public:
   inline void cellConcentration(double c) { cellConcentration_ = c; }
   inline double r() { return r_; }
   inline void r(double radius) { r_ = radius; }
+  inline double volume() { return volume_; }
+  inline double mass() { return mass_; }
   inline double temperature() { return temperature_; }
   inline void temperature(double t) { temperature_ = t; }
   inline double viscosity() { return viscosity_; }
@@ -88,7 +112,12 @@ protected:
   double viscosity_;
   double temperature_;
   double r_;
+  double volume_;                 // [um3]
+  double mass_;                   // [kg]
   bool debug_;
+  size_t obstacleHit_;
+  vector<Vec3<double>> legs_;     // reusable buffer for obstacle reflections
+  Walker* proto_;                 // walker with cloud properties for new walkers
 
 private:
   double meanVel_;
@@ -108,15 +137,25 @@ void CloudBase::setProperties(ParameterReader& pr) {
     exit(1);
   }
 
+  r_ = pr.doubleRead(cloudID()+" Particle Radius", "1")/1000.0;
+  volume_ = 4.0/3.0*M_PI*r_*r_*r_;
+  if (walkerType().find("Enzyme") != string::npos) {
+    auto density = pr.doubleRead(cloudID()+" Particle Density", "1"); // [g/cm3]
+    mass_ = volume_*density*1e-15;
+  }
   if (pr.checkName(cloudID()+" Diffusion Constant")) {
     D(pr.doubleRead(cloudID()+" Diffusion Constant", "1.0"));
   } else {
     viscosity_ = pr.doubleRead(cloudID()+" Viscosity", "0.001");
     temperature_ = pr.doubleRead(cloudID()+" Temperature", "300");
-    r_ = pr.doubleRead(cloudID()+" Particle Radius", "1")/1000.0;
     D(GSL_CONST_MKSA_BOLTZMANN*temperature_*1e18/(6.0*M_PI*viscosity_*r_));   // [um^2/s]
     cout << "... cal D: " << gre << D() << def << " [um2/s]" << endl;
   }
+
+  // fixed clouds are skipped in simulation loop
+  isStatic(pr.boolRead(cloudID()+" Static", (D() == 0.0) ? "True" : "False"));
+  if (isStatic())
+    cout << "... static cloud" << endl;
 }
 
 void CloudBase::setSubstrateCloud(Cloud* sc) {
@@ -166,6 +205,10 @@ void CloudBase::injectWalkers(ParameterReader& pr) {
       cerr << "... " << p0 << " is not inside." << endl;
       exit(1);
     }
+    if ((obs_ != nullptr) and obs_->isInside(p0, r_)) {
+      cerr << "... " << p0 << " is inside of obstacle." << endl;
+      exit(1);
+    }
   } else if (res.find("vol") !=string::npos) {
     rflag = true; sc = SurfaceTypeClass::volume;
   } else if (res.find("sur") !=string::npos) {
@@ -179,41 +222,58 @@ void CloudBase::injectWalkers(ParameterReader& pr) {
     exit(1);
   }
 
-  // create walker and set properties
+  // check walker type : Base, Enzyme
+  if (walkerType().find("Base") != string::npos) {
+    proto_ = new WalkerBase{p0};
+    pool_.slotSize(sizeof(WalkerBase));
+  } else if (walkerType().find("Enzyme") != string::npos) {
+    proto_ = new WalkerEnzyme{p0};
+    pool_.slotSize(sizeof(WalkerEnzyme));
+  } else {
+    cerr << "... not know walker type " << walkerType() << " from (Base, Enzyme)" << endl;
+    exit(1);
+  }
+  auto v1 = sf_->maxDimension();
+  auto v2 = sf_->minDimension();
+  //cout << "... pid criteria px1: " << v2.X()/2.0 << " px3: " << v1.X()/2.0 << endl;
+  setPIDRange(v2.X()/2.0, 0.0, v1.X()/2.0, 0.0, 0.0);
+
+  // create walker and set properties - one block for initial walkers
+  pool_.reserve(initialCount_);
   Walker* w;
   for(size_t i=0; i < initialCount_; i++) {
-    // calculate random position
-    if (rflag)  p0 = sf_->calRandomPosition(rs_, sc);
-
-    // check walker type : Base, Enzyme
-    if (walkerType().find("Base") != string::npos) {
-      w = new WalkerBase{p0};
-    } else if (walkerType().find("Enzyme") != string::npos) {
-      w = new WalkerEnzyme{p0};
-    } else {
-      cerr << "... not know walker type " << walkerType() << " from (Base, Enzyme)" << endl;
-      exit(1);
+    // calculate random position - keyed streams: walker i lands on the same
+    // site whatever the walkers before it drew (step 0 is before any move)
+    if (rflag) {
+      if (rs_->type == gsl_rng_philox) philox_stream(rs_, (uint32_t)i, 0);
+      p0 = calRandomPosition(sc);
     }
+
+    w = newWalker(p0);
     w->tid(i);
-    auto v1 = sf_->maxDimension();
-    auto v2 = sf_->minDimension();
-    //cout << "... pid criteria px1: " << v2.X()/2.0 << " px3: " << v1.X()/2.0 << endl;
-    w->setPIDRange(v2.X()/2.0, 0.0, v1.X()/2.0, 0.0, 0.0);
-    w->setProperties(pr, cloudID());
     addWalker(w);
   }
 
-  // show pid list and number in it
+  // show partitions and walkers in them
+  vector<size_t> pn(16, 0);
+  for (auto w : wlist_) pn[w->pid()]++;
   cout << "... pid list ";
-  for(size_t i=0; i < pidList_.size(); ++i)
-    cout << i << "(" << pidList_[i].size() << ") ";
+  for(size_t i=0; i < pn.size(); ++i)
+    cout << i << "(" << pn[i] << ") ";
   cout << endl;
 }
 
+Walker* CloudBase::newWalker(Vec3<double> p) {
+  // copy of prototype walker at p in a pool slot
+  Walker* w = proto_->clone(pool_.allocate());
+  w->position(p);
+  w->pid(calPID(p));
+  return w;
+}
+
 void CloudBase::moveWalker(double dt) {
   for (auto w : wlist_) {
-    // time(age) shift
-    w->addAge(dt);
+    selectStream(w);
 
     // fixed position clouds
     if (D() == 0.0) continue;
@@ -221,37 +281,44 @@ void CloudBase::moveWalker(double dt) {
     Vec3<double> dr;
     dr = getStep(dt);
 
+    // check obstacle hit - stop at wall after reflections
+    if (obs_ != nullptr) {
+      Vec3<double> p = w->position();
+      obstacleHit_ += obs_->calNewStep(p, dr, r_, legs_);
+      for (auto& leg : legs_) {
+        if (!sf_->isInside(p+leg)) { leg = leg*sf_->getTimeForSurface(p, leg); p += leg; break; }
+        p += leg;
+      }
+      dr = p - w->position();
+    }
+
     // check wall hit
     if (!sf_->isInside(w->position()+dr)) {
       double tt = sf_->getTimeForSurface(w->position(), dr);
+      if (map_ != nullptr) map_->add(mapWall, w->position()+dr*tt);
       dr = sf_->calNewStep(w->position(), dr, tt, 0);
       w->addWallHit(1);
       //cout << "... hit wall at " << wlist_[i].position()+dr << endl;
     }
 
     // move walker
-    auto p_pid = w->pid();
-    w->step(dr);
-    w->addAge(dt);
-    auto n_pid = w->pid();
-    if (p_pid != n_pid) {
-      pidList_[p_pid].erase(w->tid());
-      pidList_[n_pid].insert(w->tid());
-    }
+    shiftWalker(w, dr);
   }
 }
 
 void CloudBase::info(Log* log_) {
   // collect informations from walkers
   size_t totalWallHit{0};
-  double age = (*this)[0]->age();
+  double age = time_;
 
   cout << "Time: " << age << " [s]" << endl;
 
   for (auto w : wlist_) { totalWallHit += w->wallHit(); }
   cout << "Wall Hit: " << totalWallHit << endl;
-  auto wpressure = 1e14*2.0*(*this)[0]->mass()*meanVel_*(double)totalWallHit/(sf_->surfaceArea()*age);
+  auto wpressure = 1e14*2.0*mass_*meanVel_*(double)totalWallHit/(sf_->surfaceArea()*age);
   cout << "Wall Hit Pressure: " << wpressure << " [mbar]" << endl;
+  cout << "Walker Pool: " << pool_.used() << "/" << pool_.capacity() << " (" << pool_.bytes()/1024 << " [kB], "
+       << pool_.slotSize() << " [B/walker])" << endl;
 }
 #endif
 
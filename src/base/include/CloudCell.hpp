@@ -7,37 +7,84 @@
 // date: 20171006 - implement non stop movement
 // date: 20171009 - implement sweep algorithm
 // date: 20171012 - injection method
+// date: 20261018 - batch means of product rate
+// date: 20261018 - substrate candidates from segment traversal
+// date: 20261018 - bound enzymes wait in timer wheel
+// date: 20261018 - two phase walker update on a task pool
+// date: 20261018 - product by walker weight
+// date: 20261018 - relocation and field draws keyed by walker and step
+// date: 20261019 - wake step of a bound walker in closed form
+// date: 20261019 - weighted hits relocate by weight
 
 #ifndef CLOUDCELL_H
 #define CLOUDCELL_H
 
 #include "CloudBase.hpp"
+#include "CloudField.hpp"
+#include "TimerWheel.hpp"
 #include "Vec3.hpp"
 #include "ParameterReader.h"
 #include <gsl/gsl_const_num.h>
+#include <unordered_set>
 
 using namespace std;
 
+// one walker of a concurrent step: found in phase A, applied in phase B
+struct WalkerMove {
+  Vec3<double> dr;
+  uint32_t slot;                  // context with hits and wall points
+  uint32_t hitBegin, hitEnd;      // substrates in sight
+  uint32_t wallBegin, wallEnd;
+  bool moved;
+};
+
+// per thread generator and buffers
+struct MoveContext {
+  gsl_rng* rs = nullptr;
+  vector<Vec3<double>> legs;
+  vector<size_t> list;
+  vector<size_t> cells;
+  vector<Walker*> hits;
+  vector<Vec3<double>> walls;
+  uint64_t checks = 0;
+  size_t obstacleHits = 0;
+};
+
 class CloudCell: public CloudBase {
 public:
   // overloading functions
   void moveWalker(double dt);
   void info(Log* log_);
   void setSubstrateCloud(Cloud* sc);
+  BatchMeans* rateStatistics();
+  void walkersReordered();
 
   // member functions
   double getTimeForSubstrate(Vec3<double> p, Vec3<double> dr, double dt);
-  size_t countSubstrate(Vec3<double> p, Vec3<double> dr);
+  size_t countSubstrate(Vec3<double> p, Vec3<double> dr, double weight = 1.0);
   double getDuration(int count, Walker* w);
+  void updateAwake();
+  void sleep(Walker* w, double dt);
+  void moveAwake(double dt);
+  bool inSight(Vec3<double> p, Vec3<double> dr, Vec3<double> sp);
+  void moveAwakeConcurrent(double dt);
+  void planWalker(size_t k, double dt, size_t slot);
+  void collectSubstrate(Vec3<double> p, Vec3<double> dr, MoveContext& c);
+  void applyWalker(size_t k, double dt);
+  void relocateSubstrate(Walker* sw, double weight = 1.0);
 
   // constructor
   CloudCell(ParameterReader& pr, string cloudID):
     CloudBase{pr, cloudID},
     hitSubstrate_(0),
+    weightedHit_(0.0),
     focusConc_(0.0),
     substrateOn_(false),
     reactionOn_(false),
-    writeCount_(false)
+    writeCount_(false),
+    freePath_(false),
+    fieldPtr_(nullptr),
+    rateWarmup_(0)
   {
     cout << blu << "[Cell Cloud (" << cloudID << ")] is initialized" << def << endl;
 
@@ -48,10 +95,14 @@ public:
       reactionOn_ = pr.boolRead(cloudID + " Reaction On", "True");
       focusConc_ = pr.doubleRead(cloudID + " Focus Concentration", "1.0");
       substrateConstant_ = pr.boolRead(cloudID+" Substrate Constant", "True");
+      // last hit time/position per walker only with this statistics
+      freePath_ = pr.boolRead(cloudID + " Free Path Statistics", "True");
       if (reactionOn_) {
         Km_ = pr.doubleRead(cloudID + " Km", "8.9");
         Kcat_ = pr.doubleRead(cloudID + " Kcat", "6.3");
       }
+      // steady state rate after transient steps
+      rateWarmup_ = pr.intRead("converge Warmup", "1000", false);
       writeCount_ = pr.boolRead(cloudID + " Write Count", "True");
       if(writeCount_) {
         string tmp = pr.simfilename();
@@ -64,11 +115,21 @@ public:
       }
     }
   }
-  virtual ~CloudCell() { };
+  virtual ~CloudCell() {
+    for (auto& c : ctx_)
+      if (c.rs != nullptr) gsl_rng_free(c.rs);
+  };
 
   // inline functions
   inline int hitSubstrate() { return hitSubstrate_; }
   inline void hitSubstrate(int h) { hitSubstrate_ = h; }
+  // hits times weight of the enzyme - product of a resampled cloud
+  inline double weightedHit() { return weightedHit_; }
+  // product concentration after the last step [uM]
+  inline double productConcentration() { return productConcentration_.empty() ? 0.0 : productConcentration_.back(); }
+  inline Cloud* substrateCloud() { return substrateCloudPtr_; }
+  inline CloudField* field() { return fieldPtr_; }
+  inline bool substrateConstant() { return substrateConstant_; }
   inline double sightDistance() { return sightDistance_; }
   inline void sightDistance(double s) { sightDistance_ = s; }
   inline double Km() { return Km_; }
@@ -78,9 +139,11 @@ public:
 
 protected:
   size_t hitSubstrate_;
+  double weightedHit_;
   vector<double> productConcentration_;
   vector<double> freeTimeArray_;
   vector<double> freeLengthArray_;
+  vector<size_t> sslist_;         // reusable buffer for substrate candidates
   double sightDistance_;
   double focusConc_;
   double Km_;
@@ -94,7 +157,24 @@ protected:
   bool substrateConstant_;
   bool reactionOn_;
   bool writeCount_;
+  bool freePath_;
   Cloud* substrateCloudPtr_;
+  CloudField* fieldPtr_;          // substrate as mean field
+  BatchMeans rate_;               // instantaneous product rate [uM/s]
+  size_t rateWarmup_;
+
+  // walkers bound longer than a step are not visited until release
+  TimerWheel<Walker*> bound_;
+  vector<Walker*> awake_;         // moving walkers in tid order
+  vector<Walker*> woken_;
+  vector<Walker*> merged_;
+  size_t awakeVersion_ = (size_t)-1;
+
+  // concurrent step: walkers planned on the pool, applied in tid order
+  vector<MoveContext> ctx_;
+  vector<WalkerMove> moves_;
+  unordered_set<Walker*> taken_;  // substrates consumed in this step
+  vector<Walker*> hits_;
 
 private:
 
@@ -109,6 +189,7 @@ void CloudCell::setSubstrateCloud(Cloud* sc) {
   // 3. substrate off
 
   substrateCloudPtr_ = sc;
+  fieldPtr_ = dynamic_cast<CloudField*>(sc);
   cout << "... Reaction with " << substrateCloudPtr_->cloudID() << "(" << substrateCloudPtr_->walkerType() << ")" << endl;
 
   // calculate key parameters
@@ -116,7 +197,7 @@ void CloudCell::setSubstrateCloud(Cloud* sc) {
   cout << "... cal Reaction Cross-section Area: " << gre << csa << def << " [um2]" << endl;
   double mfp = 1.0e21/(GSL_CONST_NUM_AVOGADRO*sc->concentration()*csa);
   cout << "... cal Mean Free Path: " << gre << mfp << def << " [um]" << endl;
-  meanVel_ = sqrt(GSL_CONST_MKSA_BOLTZMANN*temperature()/(*this)[0]->mass());
+  meanVel_ = sqrt(GSL_CONST_MKSA_BOLTZMANN*temperature()/mass_);
   cout << "... cal Thermal Mean Velocity: " << gre << meanVel_ << def << " [um/s]" << endl;
   searchTime_ = mfp/meanVel_;
   cout << "... cal Mean Diffusion Time: " << gre << searchTime_ << def << " [s]" << endl;
@@ -141,14 +222,21 @@ void CloudCell::setSubstrateCloud(Cloud* sc) {
   }
 }
 
+BatchMeans* CloudCell::rateStatistics() {
+  // same clouds as info
+  if ((D() == 0.0) or (cloudID()=="Substrate") or !substrateOn_ or (size() == 0))
+    return nullptr;
+  return &rate_;
+}
+
 void CloudCell::info(Log* log_) {
   // if substrate cloud or fixed cloud
-  if ((D() == 0.0) or (cloudID()=="Substrate"))
+  if ((D() == 0.0) or (cloudID()=="Substrate") or !substrateOn_ or (size() == 0))
     return;
 
   // collect informations from walkers
   size_t totalWallHit{0};
-  double age = (*this)[0]->age();
+  double age = time_;
   double meanFreeTime = 0;
   double meanFreeLength = 0;
 
@@ -161,12 +249,17 @@ void CloudCell::info(Log* log_) {
 
   cout << "Time: " << age << " [s]" << endl;
   cout << "Total Product: " << hitSubstrate() << endl;
+  if (weighted())
+    cout << "Weighted Product: " << weightedHit_ << endl;
   cout << "Product Concentration: " << productConcentration_.back() << " [uM]" << endl;
   cout << "Product Rate: " << red << rate << def << " [uM/s] (" << red << inst_rate << def << ") [uM/s]" << endl;
+  if (rate_.batches() > 1)
+    cout << "Steady Rate: " << rate_.mean() << " +- " << rate_.stdError() << " [uM/s] (" << 100.0*rate_.relError()
+         << " %, " << rate_.batches() << " x " << rate_.batchSize() << " steps, lag1 " << rate_.lag1() << ")" << endl;
 
   for (auto w : wlist_) { totalWallHit += w->wallHit(); }
   cout << "Wall Hit: " << totalWallHit << endl;
-  auto wpressure = 1e14*2.0*(*this)[0]->mass()*meanVel_*(double)totalWallHit/(sf_->surfaceArea()*age);
+  auto wpressure = 1e14*2.0*mass_*meanVel_*(double)totalWallHit/(sf_->surfaceArea()*age);
   cout << "Wall Hit Pressure: " << wpressure << " [mbar]" << endl;
 
   for (auto ft : freeTimeArray_) meanFreeTime += ft;
@@ -177,11 +270,14 @@ void CloudCell::info(Log* log_) {
   }
   cout << "Mean Free Time: " << meanFreeTime << " [s] (" << freeTimeArray_.size() << ")" << endl;
   cout << "Mean Free Length: " << meanFreeLength << " [um] (" << freeLengthArray_.size() << ")" << endl;
+  if (obs_ != nullptr)
+    cout << "Obstacle Hit: " << obstacleHit_ << endl;
+  cout << "Bound: " << wake_.size() - count(wake_.begin(), wake_.end(), 0) << " (" << size() << ")" << endl;
 
   // features on save file
   string log_msg = to_string(age)+" "+
                    to_string(focusConc_)+" "+
-                   to_string((*this)[0]->r())+" "+
+                   to_string(r_)+" "+
                    to_string(substrateCloudPtr_->cellConcentration())+" "+
                    to_string(hitSubstrate())+" "+
                    to_string(productConcentration_.back())+" "+
@@ -208,10 +304,29 @@ void CloudCell::info(Log* log_) {
 
 void CloudCell::moveWalker(double dt) {
 
+  updateAwake();
+
+  // keyed streams make the walkers independent of the thread that moves them
+  if ((walkerPool_ != nullptr) and (rs_->type == gsl_rng_philox) and (fieldPtr_ == nullptr))
+    moveAwakeConcurrent(dt);
+  else
+    moveAwake(dt);
+
+  // keep counting product concentration
+  // volume [um3], concentration [uM], 1 [uL] = 1e+3 [m3]
+  double pc = weightedHit_/(sf_->volume()*GSL_CONST_NUM_AVOGADRO*1e-21);
+  if ((step_ > rateWarmup_) and !productConcentration_.empty())
+    rate_.add((pc - productConcentration_.back())/dt);
+  productConcentration_.push_back(pc);
+}
+
+void CloudCell::moveAwake(double dt) {
   // move walkers for total dt time
-  for (auto w : wlist_) {
-    // time(age) shift
-    w->addAge(dt);
+  for (auto w : awake_) {
+    selectStream(w);
+    // mean field encounters drawn for this enzyme and step
+    if ((fieldPtr_ != nullptr) and (fieldPtr_->rs()->type == gsl_rng_philox))
+      philox_stream(fieldPtr_->rs(), (uint32_t)outputTid(w), (uint32_t)step_, 1);
 
     // fixed position clouds
     if (D() == 0.0) continue;
@@ -230,7 +345,6 @@ void CloudCell::moveWalker(double dt) {
           cout << red << "... subcycle[" << subcycleIteration << "] stay - pt_: " << pt_ << " duration_: " << w->duration() << def << endl;
         w->subDuration(pt_);
         pt_ = 0.0;
-        w->step(Vec3<double>{0.0, 0.0, 0.0});
         continue;
       }
 
@@ -251,35 +365,50 @@ void CloudCell::moveWalker(double dt) {
         double tt_w = sf_->getTimeForSurface(w->position(), dr);
         size_t substrate_number = 0;
 
+        // Case6: obstacle hit before wall hit - follow reflected legs
+        size_t oid;
+        if ((obs_ != nullptr) and (obs_->getTimeForObstacle(w->position(), dr, r_, oid) < min(tt_w, 1.0))) {
+          obstacleHit_ += obs_->calNewStep(w->position(), dr, r_, legs_);
+          Vec3<double> p = w->position();
+          for (auto& leg : legs_) {
+            double tt_l = sf_->getTimeForSurface(p, leg);
+            bool wall = (tt_l < 1.0) and (tt_l >= 0.0);
+            if (wall) {
+              leg = leg*tt_l;
+              w->addWallHit(1);
+              if (map_ != nullptr) map_->add(mapWall, p+leg);
+            }
+            if (substrateOn_ and (leg.mag2() > 0.0)) substrate_number += countSubstrate(p, leg, weight(w));
+            p += leg;
+            if (wall) break;
+          }
+          dr = p - w->position();
+          if (debug_)
+            cout << red << "... subcycle[" << subcycleIteration << "] found obstacle - legs: " << legs_.size() << def << endl;
         // Case3: wall hit before substrate hit
-        if ((tt_w < 1.0) and (tt_w >= 0.0)) {
+        } else if ((tt_w < 1.0) and (tt_w >= 0.0)) {
           // substrate collision count with wall hit
           Vec3<double> dr0 = dr;
           dr = sf_->calNewStep(w->position(), dr, tt_w, 0);
           if (substrateOn_) {
-            substrate_number += countSubstrate(w->position(), dr0*tt_w);
-            substrate_number += countSubstrate(w->position()+dr0*tt_w, dr - dr0*tt_w);
+            substrate_number += countSubstrate(w->position(), dr0*tt_w, weight(w));
+            substrate_number += countSubstrate(w->position()+dr0*tt_w, dr - dr0*tt_w, weight(w));
           }
           if (debug_)
             cout << red << "... subcycle[" << subcycleIteration << "] found wall - pt_: " << pt_*tt_w << def << endl;
           w->addWallHit(1);
+          if (map_ != nullptr) map_->add(mapWall, w->position()+dr0*tt_w);
           //substrate_number += countSubstrate(w, dr*tt_w);
         } else {
           // substrate collision count without wall hit
-          if (substrateOn_) substrate_number += countSubstrate(w->position(), dr);
+          if (substrateOn_) substrate_number += countSubstrate(w->position(), dr, weight(w));
         }
 
         // Case4: freely move
         if (debug_)
           cout << red << "... subcycle[" << subcycleIteration << "] move - pt_: " << pt_ << " duration_: " << w->duration() << def << endl;
         //  update pid list
-        auto p_pid = w->pid();
-        w->step(dr);
-        auto n_pid = w->pid();
-        if (p_pid != n_pid) {
-          pidList_[p_pid].erase(w->tid());
-          pidList_[n_pid].insert(w->tid());
-        }
+        shiftWalker(w, dr);
         pt_ = 0.0;
 
         // Case5: substrate hit before wall hit
@@ -287,27 +416,237 @@ void CloudCell::moveWalker(double dt) {
           // calculate duration based on substrate count
           w->duration(getDuration(substrate_number, w));
           w->addSubstrateHit(substrate_number);
+          weightedHit_ += weight(w)*substrate_number;
+          if (map_ != nullptr) map_->add(mapReaction, w->position());
 
           if (debug_)
             cout << red << "... subcycle[" << subcycleIteration << "] (" << w->pid() << ") found " << substrate_number << " substrates at tt_w= " << tt_w << " with duration = " << w->duration() << " [s] " << def << endl;
 
           // calculate free time before the reaction
-          if (w->lastHitAge() > 0.0) {
-            double ft = w->age() - w->lastHitAge();
-            freeTimeArray_.push_back(ft);
-            freeLengthArray_.push_back((w->position() - w->lastHitPosition()).mag());
+          if (freePath_) {
+            WalkerStats* ws = statsOf(w);
+            if (ws->lastHitAge > 0.0) {
+              double ft = time_ - ws->lastHitAge;
+              freeTimeArray_.push_back(ft);
+              freeLengthArray_.push_back((w->position() - ws->lastHitPosition).mag());
+            }
+            ws->lastHitAge = time_;
+            ws->lastHitPosition = w->position();
           }
-          w->lastHitAge(w->age());
-          w->lastHitPosition(w->position());
 
         }
       }
     }
+
+    // bound beyond the next step
+    if (w->duration() > dt) sleep(w, dt);
   }
-  // keep counting product concentration
-  // volume [um3], concentration [uM], 1 [uL] = 1e+3 [m3]
-  double pc = (double)(hitSubstrate_)/(sf_->volume()*GSL_CONST_NUM_AVOGADRO*1e-21);
-  productConcentration_.push_back(pc);
+}
+
+void CloudCell::moveAwakeConcurrent(double dt) {
+  // phase A on the pool: steps, reflections and substrates in sight, with the
+  // grids as they were at the start of the step. phase B in tid order: moves,
+  // first come takes a substrate, durations and sleep.
+  if (substrateOn_) substrateCloudPtr_->prepareLocationList(sightDistance_);
+  if (ctx_.size() < walkerPool_->threads()) ctx_.resize(walkerPool_->threads());
+  for (auto& c : ctx_) {
+    if (c.rs == nullptr) c.rs = gsl_rng_clone(rs_);
+    c.hits.clear();
+    c.walls.clear();
+    c.checks = 0;
+    c.obstacleHits = 0;
+  }
+  moves_.resize(awake_.size());
+
+  walkerPool_->parallelFor(awake_.size(), walkerGrain_, [this, dt](size_t b, size_t e, size_t slot) {
+    for (size_t k=b; k < e; ++k) planWalker(k, dt, slot);
+  });
+
+  taken_.clear();
+  for (size_t k=0; k < awake_.size(); ++k) applyWalker(k, dt);
+  for (auto& c : ctx_) {
+    checkCount_ += c.checks;
+    obstacleHit_ += c.obstacleHits;
+  }
+}
+
+void CloudCell::planWalker(size_t k, double dt, size_t slot) {
+  // same cases as moveAwake, without touching anything but walker k
+  Walker* w = awake_[k];
+  MoveContext& c = ctx_[slot];
+  WalkerMove& m = moves_[k];
+  m.moved = false;
+  m.slot = (uint32_t)slot;
+  m.hitBegin = m.hitEnd = (uint32_t)c.hits.size();
+  m.wallBegin = m.wallEnd = (uint32_t)c.walls.size();
+
+  selectStream(w, c.rs);
+  if (D() == 0.0) return;
+
+  // Case1: enzyme full stay, Case2: partial stay
+  double pt = dt;
+  if (w->duration() > pt) {
+    w->subDuration(pt);
+    return;
+  }
+  if (w->duration() > 0.0) {
+    pt -= w->duration();
+    w->duration(0.0);
+  }
+
+  Vec3<double> p0 = w->position();
+  Vec3<double> dr = getStep(pt, c.rs);
+  double tt_w = sf_->getTimeForSurface(p0, dr);
+
+  // Case6: obstacle, Case3: wall, else free move
+  size_t oid;
+  if ((obs_ != nullptr) and (obs_->getTimeForObstacle(p0, dr, r_, oid) < min(tt_w, 1.0))) {
+    c.obstacleHits += obs_->calNewStep(p0, dr, r_, c.legs);
+    Vec3<double> p = p0;
+    for (auto& leg : c.legs) {
+      double tt_l = sf_->getTimeForSurface(p, leg);
+      bool wall = (tt_l < 1.0) and (tt_l >= 0.0);
+      if (wall) {
+        leg = leg*tt_l;
+        c.walls.push_back(p+leg);
+      }
+      if (substrateOn_ and (leg.mag2() > 0.0)) collectSubstrate(p, leg, c);
+      p += leg;
+      if (wall) break;
+    }
+    dr = p - p0;
+  } else if ((tt_w < 1.0) and (tt_w >= 0.0)) {
+    Vec3<double> dr0 = dr;
+    dr = sf_->calNewStep(p0, dr, tt_w, 0);
+    if (substrateOn_) {
+      collectSubstrate(p0, dr0*tt_w, c);
+      collectSubstrate(p0+dr0*tt_w, dr - dr0*tt_w, c);
+    }
+    c.walls.push_back(p0+dr0*tt_w);
+  } else if (substrateOn_) {
+    collectSubstrate(p0, dr, c);
+  }
+
+  m.dr = dr;
+  m.moved = true;
+  m.hitEnd = (uint32_t)c.hits.size();
+  m.wallEnd = (uint32_t)c.walls.size();
+}
+
+void CloudCell::collectSubstrate(Vec3<double> p, Vec3<double> dr, MoveContext& c) {
+  substrateCloudPtr_->getLocationList(p, dr, c.list, c.cells);
+  c.checks += c.list.size();
+  for (auto i : c.list) {
+    Walker* s = (*substrateCloudPtr_)[i];
+    if (inSight(p, dr, s->position())) c.hits.push_back(s);
+  }
+}
+
+void CloudCell::applyWalker(size_t k, double dt) {
+  Walker* w = awake_[k];
+  WalkerMove& m = moves_[k];
+
+  if (m.moved) {
+    MoveContext& c = ctx_[m.slot];
+    for (uint32_t j=m.wallBegin; j < m.wallEnd; ++j) {
+      w->addWallHit(1);
+      if (map_ != nullptr) map_->add(mapWall, c.walls[j]);
+    }
+    shiftWalker(w, m.dr);
+
+    // substrates taken by an earlier walker of this step are gone
+    bool consume = !substrateConstant_ or (focusConc_ == 0.0);
+    hits_.clear();
+    for (uint32_t j=m.hitBegin; j < m.hitEnd; ++j)
+      if (!consume or taken_.insert(c.hits[j]).second) hits_.push_back(c.hits[j]);
+
+    size_t n = hits_.size();
+    if (n > 0) {
+      // same order as countSubstrate
+      if (!substrateConstant_) {
+        sort(hits_.begin(), hits_.end(), [](Walker* a, Walker* b) { return a->tid() > b->tid(); });
+        for (auto sw : hits_) substrateCloudPtr_->removeWalker(sw->tid());
+      } else if (focusConc_ == 0.0) {
+        sort(hits_.begin(), hits_.end(), [&](Walker* a, Walker* b) {
+          return substrateCloudPtr_->outputTid(a) > substrateCloudPtr_->outputTid(b); });
+        for (auto sw : hits_) relocateSubstrate(sw, weight(w));
+      }
+      hitSubstrate_ += n;
+      weightedHit_ += weight(w)*n;
+
+      w->duration(getDuration(n, w));
+      w->addSubstrateHit(n);
+      if (map_ != nullptr) map_->add(mapReaction, w->position());
+      if (freePath_) {
+        WalkerStats* ws = statsOf(w);
+        if (ws->lastHitAge > 0.0) {
+          freeTimeArray_.push_back(time_ - ws->lastHitAge);
+          freeLengthArray_.push_back((w->position() - ws->lastHitPosition).mag());
+        }
+        ws->lastHitAge = time_;
+        ws->lastHitPosition = w->position();
+      }
+    }
+  }
+
+  // bound beyond the next step
+  if (w->duration() > dt) sleep(w, dt);
+}
+
+void CloudCell::updateAwake() {
+  if (wake_.size() < wlist_.size()) wake_.resize(wlist_.size(), 0);
+
+  // released in this step - entries of removed walkers are stale
+  woken_.clear();
+  bound_.advance(step_, woken_);
+  size_t n = 0;
+  for (auto w : woken_) {
+    size_t tid = w->tid();
+    if ((tid < wlist_.size()) and (wlist_[tid] == w) and (wake_[tid] == step_)) {
+      wake_[tid] = 0;
+      woken_[n++] = w;
+    }
+  }
+  woken_.resize(n);
+
+  // walkers added or removed - new tids
+  if (awakeVersion_ != updateCount_) {
+    awake_.clear();
+    for (auto w : wlist_)
+      if (wake_[w->tid()] == 0) awake_.push_back(w);
+    awakeVersion_ = updateCount_;
+    return;
+  }
+
+  // drop walkers bound in the last step, released ones in tid order (same order as wlist_)
+  n = 0;
+  for (auto w : awake_)
+    if (wake_[w->tid()] == 0) awake_[n++] = w;
+  awake_.resize(n);
+  if (woken_.empty()) return;
+  auto byTid = [](Walker* a, Walker* b) { return a->tid() < b->tid(); };
+  sort(woken_.begin(), woken_.end(), byTid);
+  merged_.clear();
+  merge(awake_.begin(), awake_.end(), woken_.begin(), woken_.end(), back_inserter(merged_), byTid);
+  awake_.swap(merged_);
+}
+
+void CloudCell::walkersReordered() {
+  // wheel entries point to records that moved
+  bound_.clear();
+  for (size_t i=0; i < wake_.size(); ++i)
+    if (wake_[i] > 0) bound_.insert(wlist_[i], wake_[i]);
+}
+
+void CloudCell::sleep(Walker* w, double dt) {
+  // whole steps asleep, duration left at release in (0, dt]
+  double d = w->duration();
+  double r = fmod(d, dt);
+  if (r == 0.0) r = dt;
+  uint64_t due = step_ + 1 + (uint64_t)llround((d - r)/dt);
+  w->duration(r);
+  wake_[w->tid()] = due;
+  bound_.insert(w, due);
 }
 
 double CloudCell::getDuration(int count, Walker* w) {
@@ -316,19 +655,19 @@ double CloudCell::getDuration(int count, Walker* w) {
     if(!reactionOn_) { return 0.0; }
 
     // for diffusion case (using diffusion-limited on rate)
-    float residence_time = reactionTime_ - searchTime_;
+    double residence_time = reactionTime_ - searchTime_;
 
     // for cluster reaction case
     if (focusConc_>0.0) {
       // using Michaelis-Menten equation (constant)
-      double substrate_conc = count/(w->volume()*1e-18*GSL_CONST_NUM_AVOGADRO*1e-3);  // [uM]
+      double substrate_conc = count/(volume_*1e-18*GSL_CONST_NUM_AVOGADRO*1e-3);  // [uM]
       //substrate_conc = substrateCloudPtr_->concentration();
-      double clusterConc = (focusConc_*sf_->volume()/w->volume()); // [uM]
+      double clusterConc = (focusConc_*sf_->volume()/volume_); // [uM]
       residence_time = (Km_ + substrate_conc)/(Kcat_*clusterConc);
       //residence_time = Km_/(Kcat_*clusterConc);
 
       if (debug_) {
-        cout << "... [" << this->cloudID_ << "][" << w->tid() << "] t=" << w->age() << " capture: " << count << " residence_time: " << residence_time << " [s] " << endl;
+        cout << "... [" << this->cloudID_ << "][" << w->tid() << "] t=" << time_ << " capture: " << count << " residence_time: " << residence_time << " [s] " << endl;
         cout << "    substrate concentration [uM]: " << substrate_conc << " cluster concentration [uM]: " << clusterConc << endl;
       }
     }
@@ -336,31 +675,32 @@ double CloudCell::getDuration(int count, Walker* w) {
     return residence_time;
 }
 
-size_t CloudCell::countSubstrate(Vec3<double> p, Vec3<double> dr) {
+size_t CloudCell::countSubstrate(Vec3<double> p, Vec3<double> dr, double weight) {
+  // mean field substrate: Poisson encounters along segment
+  if (fieldPtr_ != nullptr) {
+    size_t count = fieldPtr_->sample(p, dr, sightDistance_, !substrateConstant_);
+    hitSubstrate_ += count;
+    return count;
+  }
+
   vector<size_t> sublist;
 
   // check for all substrates
-  auto sslist = substrateCloudPtr_->getLocationList(p, dr);
-  for(auto i : sslist) {
+  substrateCloudPtr_->getLocationList(p, dr, sightDistance_, sslist_);
+  checkCount_ += sslist_.size();
+  for(auto i : sslist_) {
     // count all substrate around current position
-    Vec3<double> new_position = p + dr;
-    Vec3<double> sp = (*substrateCloudPtr_)[i]->position();
-    double pr = sightDistance_/dr.mag();
-    double t = Vec3<double>::dotProduct(new_position-sp, dr)/dr.mag2();
-    if ((t>0.0) and (t<=1.0)) {
-      if((new_position*t+p*(1.0-t)-sp).mag() <= sightDistance_) {
-        sublist.push_back(i);
-        // cout << "... found [" << i << "] in " << sslist.size() << endl;
-      }
-    } else if ((t>0.0) and (t <= 1.0+pr)) {
-      if((sp - new_position).mag() <= sightDistance_) {
-        sublist.push_back(i);
-      // cout << "... found [" << i << "] in " << sslist.size() << endl;
-      }
-    }
+    if (inSight(p, dr, (*substrateCloudPtr_)[i]->position())) sublist.push_back(i);
   }
 
   if (sublist.size() == 0) return 0;
+  // remove from back - removeWalker moves the last walker into the index;
+  // relocations in output order, so reordered records draw the same positions
+  if (!substrateConstant_)
+    sort(sublist.begin(), sublist.end(), greater<size_t>());
+  else
+    sort(sublist.begin(), sublist.end(), [&](size_t a, size_t b) {
+      return substrateCloudPtr_->outputTid((*substrateCloudPtr_)[a]) > substrateCloudPtr_->outputTid((*substrateCloudPtr_)[b]); });
 
   for(auto subidx : sublist) {
     if (!substrateConstant_) {
@@ -368,12 +708,8 @@ size_t CloudCell::countSubstrate(Vec3<double> p, Vec3<double> dr) {
       if (debug_) cerr << "... remove substrate [" << subidx << "]" << endl;
       substrateCloudPtr_->removeWalker(subidx);
     } else {
-      if (focusConc_ == 0.0) {
-        // make new active site
-        Vec3<double> temp = (substrateCloudPtr_->sf())->calRandomPosition(rs_);
-        (*substrateCloudPtr_)[subidx]->position(temp);
-        (*substrateCloudPtr_)[subidx]->pid((*substrateCloudPtr_)[subidx]->calPID());
-      }
+      // make new active site
+      if (focusConc_ == 0.0) relocateSubstrate((*substrateCloudPtr_)[subidx], weight);
       // let points stay in case of cluster
     }
   }
@@ -383,22 +719,44 @@ size_t CloudCell::countSubstrate(Vec3<double> p, Vec3<double> dr) {
   return sublist.size();
 }
 
+void CloudCell::relocateSubstrate(Walker* sw, double weight) {
+  // keyed streams: site by substrate and step, not by the hits before it
+  gsl_rng* r = substrateCloudPtr_->rs();
+  if (r->type == gsl_rng_philox)
+    philox_stream(r, (uint32_t)substrateCloudPtr_->outputTid(sw), (uint32_t)step_, 1);
+  // replica of weight < 1: shared site moves as often as for one enzyme
+  if ((weight < 1.0) and (gsl_rng_uniform(r) >= weight)) return;
+  Vec3<double> temp = substrateCloudPtr_->calRandomPosition();
+  substrateCloudPtr_->shiftWalker(sw, temp - sw->position());
+}
+
+bool CloudCell::inSight(Vec3<double> p, Vec3<double> dr, Vec3<double> sp) {
+  // foot of substrate on the segment p + t*dr, or just beyond its end
+  double pr = sightDistance_/dr.mag();
+  double t = Vec3<double>::dotProduct(sp-p, dr)/dr.mag2();
+  if ((t>0.0) and (t<=1.0))
+    return (p+dr*t-sp).mag() <= sightDistance_;
+  if ((t>0.0) and (t <= 1.0+pr))
+    return (sp - (p+dr)).mag() <= sightDistance_;
+  return false;
+}
+
 double CloudCell::getTimeForSubstrate(Vec3<double> p, Vec3<double> dr, double dt) {
   if (!substrateOn_)
     return 2.0;
 
-  auto new_position = p+dr;
   double min_t = 2.0;
   double max_t = 0.0;
 
-  auto sslist = substrateCloudPtr_->getLocationList(p, dr);
-  for(auto i : sslist) {
+  substrateCloudPtr_->getLocationList(p, dr, sightDistance_, sslist_);
+  checkCount_ += sslist_.size();
+  for(auto i : sslist_) {
     Vec3<double> aS{(*substrateCloudPtr_)[i]->position()};
 
     // find collision condition for trajectory
-    double t = Vec3<double>::dotProduct(new_position-aS, dr)/dr.mag2();
+    double t = Vec3<double>::dotProduct(aS-p, dr)/dr.mag2();
     if ((t>0.0) and (t<=1.0)) {
-      if((new_position*t+p*(1.0-t)-aS).mag() <= sightDistance_) {
+      if((p+dr*t-aS).mag() <= sightDistance_) {
         if (debug_)
           cout << "... stop at substrate[" << i << "] (" << (*substrateCloudPtr_)[i]->pid() << ") p=" << p << " t = " << t << endl;
         if (min_t > t) min_t = t;
@@ -0,0 +1,228 @@
+// CloudField.hpp
+// mean-field substrate cloud - voxel number field with diffusion on grid
+//
+// author: sungcheolkim @ IBM
+// date: 20261018 - initial version (Poisson encounters on swept segment)
+// date: 20261019 - unnamed parameters of overrides that do not use them
+// date: 20261019 - products capped by the molecules removed from the field
+//
+// abundant substrates are kept as expected molecule numbers on voxels inside
+// the surface instead of walkers. an enzyme moving along a segment meets
+// Poisson(rho * pi * s^2 * length) substrates (s = sight distance), evaluated
+// voxel by voxel, and removes them from the voxels where they were met unless
+// the substrate is constant. a depleting field gives no more products than
+// molecules were removed. the field diffuses with explicit substeps
+// (D dt/h^2 <= 1/6, no flux across the surface) once it has been depleted.
+// the cost does not depend on the substrate number.
+
+#ifndef CLOUDFIELD_H
+#define CLOUDFIELD_H
+
+#include <vector>
+#include <math.h>
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_randist.h>
+#include <gsl/gsl_const_num.h>
+#include "CloudBase.hpp"
+#include "Vec3.hpp"
+#include "ParameterReader.h"
+
+using namespace std;
+
+class CloudField: public CloudBase {
+public:
+  // overloading functions
+  void injectWalkers(ParameterReader& pr);
+  void moveWalker(double dt);
+  void info(Log* log_);
+  Walker* newWalker(Vec3<double> p);
+
+  // member functions
+  size_t sample(Vec3<double> p, Vec3<double> dr, double s, bool deplete);
+  double total();
+
+  // constructor
+  CloudField(ParameterReader& pr, string cloudID):
+    CloudBase{pr, cloudID},
+    nx_(1), ny_(1), nz_(1),
+    inside_(0),
+    depleted_(false),
+    met_(0),
+    removed_(0.0)
+  {
+    cout << blu << "[Field Cloud (" << cloudID << ")] is initialized" << def << endl;
+
+    h_ = pr.doubleRead(cloudID + " Voxel Size", "100")/1000.0;     // [nm] -> [um]
+    // field concentration is updated in moveWalker
+    isStatic(false);
+  }
+  virtual ~CloudField() { };
+
+  // inline functions
+  inline double h() { return h_; }
+  inline size_t met() { return met_; }
+
+private:
+  inline long voxelOf(Vec3<double> p) {
+    long ix = (long)floor((p.X()-lo_.X())/h_);
+    long iy = (long)floor((p.Y()-lo_.Y())/h_);
+    long iz = (long)floor((p.Z()-lo_.Z())/h_);
+    if ((ix < 0) or (iy < 0) or (iz < 0) or (ix >= nx_) or (iy >= ny_) or (iz >= nz_)) return -1;
+    long v = (iz*ny_ + iy)*nx_ + ix;
+    return mask_[v] ? v : -1;
+  }
+  void updateConcentration();
+
+  Vec3<double> lo_;
+  double h_;
+  long nx_, ny_, nz_;
+  size_t inside_;
+  bool depleted_;
+  size_t met_;
+  double removed_;            // removed molecules not yet counted as products
+  vector<double> n_;          // expected molecules in voxel
+  vector<double> nn_;         // buffer for diffusion substep
+  vector<char> mask_;         // voxel center inside surface
+  vector<long> piece_;        // reusable buffers for segment sampling
+  vector<double> lambda_;
+};
+
+void CloudField::injectWalkers(ParameterReader& pr) {
+  double count;
+
+  // calculate molecule number
+  if (pr.checkName(cloudID_+" Particle Number")) {
+    count = (double)pr.intRead(cloudID_+" Particle Number", "1");
+  } else {
+    cellConcentration(pr.doubleRead(cloudID_+" Concentration", "1.0"));
+    count = cellConcentration()*sf_->volume()*GSL_CONST_NUM_AVOGADRO*1e-21;
+    cout << "... cal Particle Number: " << gre << count << def << endl;
+  }
+
+  // voxel grid over surface
+  lo_ = sf_->minDimension();
+  Vec3<double> ext = sf_->maxDimension() - lo_;
+  nx_ = max(1L, (long)ceil(ext.X()/h_));
+  ny_ = max(1L, (long)ceil(ext.Y()/h_));
+  nz_ = max(1L, (long)ceil(ext.Z()/h_));
+  mask_.assign(nx_*ny_*nz_, 0);
+  for (long iz=0; iz < nz_; ++iz)
+    for (long iy=0; iy < ny_; ++iy)
+      for (long ix=0; ix < nx_; ++ix) {
+        Vec3<double> c{lo_.X()+(ix+0.5)*h_, lo_.Y()+(iy+0.5)*h_, lo_.Z()+(iz+0.5)*h_};
+        if (sf_->isInside(c)) { mask_[(iz*ny_ + iy)*nx_ + ix] = 1; inside_++; }
+      }
+  if (inside_ == 0) {
+    cerr << "... no voxel inside surface with voxel size " << h_ << " [um]" << endl;
+    exit(1);
+  }
+
+  // uniform field
+  n_.assign(mask_.size(), 0.0);
+  for (size_t v=0; v < mask_.size(); ++v)
+    if (mask_[v]) n_[v] = count/inside_;
+  nn_ = n_;
+  updateConcentration();
+
+  cout << "... cal Voxel Number: " << gre << inside_ << def << " (" << nx_ << "x" << ny_ << "x" << nz_ << ")" << endl;
+  cout << "... inject " << gre << count << def << " molecules as field in Cloud(" << cloudID() << ")" << endl;
+  if (count/inside_ < 1.0)
+    cout << red << "... less than one molecule per voxel: a depleting field gives products up to voxel content, raise " << cloudID() << " Voxel Size" << def << endl;
+}
+
+Walker* CloudField::newWalker(Vec3<double>) {
+  cerr << "... CloudField: cannot create walker in field cloud " << cloudID() << endl;
+  exit(1);
+}
+
+size_t CloudField::sample(Vec3<double> p, Vec3<double> dr, double s, bool deplete) {
+  // expected encounters on each voxel-sized piece of the segment
+  double len = dr.mag();
+  size_t m = max((size_t)1, (size_t)ceil(len/h_));
+  double area = M_PI*s*s*len/m/(h_*h_*h_);
+  double sum = 0.0;
+
+  piece_.resize(m);
+  lambda_.resize(m);
+  for (size_t k=0; k < m; ++k) {
+    piece_[k] = voxelOf(p + dr*((k + 0.5)/m));
+    lambda_[k] = (piece_[k] < 0) ? 0.0 : n_[piece_[k]]*area;
+    sum += lambda_[k];
+  }
+  if (sum == 0.0) return 0;
+
+  size_t count = gsl_ran_poisson(rs_, sum);
+  met_ += count;
+  if (!deplete or (count == 0)) return count;
+
+  // remove from the voxels where substrates were met - the walk passes
+  // pieces outside the surface (lambda 0) and ends on the last inside one
+  size_t last = m-1;
+  while (lambda_[last] == 0.0) --last;
+  for (size_t c=0; c < count; ++c) {
+    double u = gsl_rng_uniform(rs_)*sum;
+    size_t k = 0;
+    while ((k < last) and (u >= lambda_[k])) { u -= lambda_[k]; ++k; }
+    double take = min(1.0, n_[piece_[k]]);
+    n_[piece_[k]] -= take;
+    removed_ += take;
+  }
+  depleted_ = true;
+
+  // whole molecules removed so far, fractions carry over to later draws
+  count = min(count, (size_t)floor(removed_));
+  removed_ -= count;
+  return count;
+}
+
+void CloudField::moveWalker(double dt) {
+  // uniform field stays uniform
+  if ((D() == 0.0) or !depleted_) {
+    updateConcentration();
+    return;
+  }
+
+  size_t nsub = (size_t)ceil(6.0*D()*dt/(h_*h_));
+  double lambda = D()*dt/nsub/(h_*h_);
+  long sx = 1, sy = nx_, sz = nx_*ny_;
+
+  for (size_t k=0; k < nsub; ++k) {
+    for (long iz=0; iz < nz_; ++iz)
+      for (long iy=0; iy < ny_; ++iy)
+        for (long ix=0; ix < nx_; ++ix) {
+          long v = (iz*ny_ + iy)*nx_ + ix;
+          if (!mask_[v]) continue;
+          // exchange with inside neighbors only (no flux across surface)
+          double flux = 0.0;
+          if ((ix > 0) and mask_[v-sx]) flux += n_[v-sx] - n_[v];
+          if ((ix+1 < nx_) and mask_[v+sx]) flux += n_[v+sx] - n_[v];
+          if ((iy > 0) and mask_[v-sy]) flux += n_[v-sy] - n_[v];
+          if ((iy+1 < ny_) and mask_[v+sy]) flux += n_[v+sy] - n_[v];
+          if ((iz > 0) and mask_[v-sz]) flux += n_[v-sz] - n_[v];
+          if ((iz+1 < nz_) and mask_[v+sz]) flux += n_[v+sz] - n_[v];
+          nn_[v] = n_[v] + lambda*flux;
+        }
+    n_.swap(nn_);
+  }
+  updateConcentration();
+}
+
+double CloudField::total() {
+  double t = 0.0;
+  for (auto n : n_) t += n;
+  return t;
+}
+
+void CloudField::updateConcentration() {
+  double t = total();
+  cellConcentration(t/(sf_->volume()*GSL_CONST_NUM_AVOGADRO*1e-21));
+  concentration(t/(sf_->typeVolume()*GSL_CONST_NUM_AVOGADRO*1e-21));
+}
+
+void CloudField::info(Log*) {
+  cout << "Field " << cloudID() << ": " << total() << " (" << cellConcentration() << " [uM]) Met: " << met_ << endl;
+}
+
+#endif
+
+// vim:foldmethod=syntax:foldlevel=0
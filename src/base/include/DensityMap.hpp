@@ -0,0 +1,129 @@
+// DensityMap.hpp
+// voxel histograms of walker positions, reaction and wall hit sites
+//
+// author: sungcheolkim @ IBM
+// date: 20261018 - initial version (occupancy, reaction, wall, projections)
+// date: 20261019 - one map per cloud, no merge
+//
+// counts of voxel v are counts_[map][v], v = (iz*ny + iy)*nx + ix. positions
+// outside the grid go to the border voxel (clamp, no test). walker threads
+// only record sites; they are added in the serial apply pass of the cloud.
+//
+// file (little endian): DensityMapHeader, then the 3d maps (uint64, occupancy,
+// reaction, wall), then for each map its projections along z (ny x nx),
+// y (nz x nx) and x (nz x ny). the file is rewritten with every write.
+
+#ifndef DENSITYMAP_H
+#define DENSITYMAP_H
+
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include "Vec3.hpp"
+
+using namespace std;
+
+enum DensityMapType { mapOccupancy=0, mapReaction=1, mapWall=2, mapNumber=3 };
+
+struct DensityMapHeader {
+  char magic[8];                // "LEVYMAP1"
+  uint32_t nx, ny, nz;
+  uint32_t maps;
+  double lo[3];                 // grid corner [um]
+  double h;                     // voxel size [um]
+  double t;                     // time of write [s]
+  uint64_t samples;             // occupancy samples (frames)
+};
+
+static_assert(sizeof(DensityMapHeader) == 72, "density map header layout");
+
+class DensityMap {
+
+public:
+  // member functions
+  void setGrid(Vec3<double> lo, Vec3<double> hi, double h);
+  size_t write(string fn, double t);
+
+  // constructor
+  DensityMap(): h_(1.0), nx_(1), ny_(1), nz_(1), samples_(0) { }
+  virtual ~DensityMap() { };
+
+  // inline functions
+  inline size_t voxelOf(Vec3<double> p) {
+    return (size_t)((clamp((p.Z()-lo_.Z())/h_, nz_)*ny_ + clamp((p.Y()-lo_.Y())/h_, ny_))*nx_
+                    + clamp((p.X()-lo_.X())/h_, nx_));
+  }
+  inline void add(DensityMapType k, Vec3<double> p) { counts_[k][voxelOf(p)]++; }
+  inline void addSample() { samples_++; }
+  inline size_t size() { return (size_t)(nx_*ny_*nz_); }
+  inline uint64_t count(DensityMapType k, size_t v) { return counts_[k][v]; }
+
+private:
+  inline long clamp(double v, long n) { return min(max((long)floor(v), 0L), n-1); }
+
+  Vec3<double> lo_;
+  double h_;
+  long nx_, ny_, nz_;
+  uint64_t samples_;
+  vector<uint64_t> counts_[mapNumber];
+  vector<uint64_t> proj_;               // projection buffer for write
+};
+
+void DensityMap::setGrid(Vec3<double> lo, Vec3<double> hi, double h) {
+  lo_ = lo;
+  h_ = h;
+  Vec3<double> ext = hi - lo;
+  nx_ = max(1L, (long)ceil(ext.X()/h_));
+  ny_ = max(1L, (long)ceil(ext.Y()/h_));
+  nz_ = max(1L, (long)ceil(ext.Z()/h_));
+  for (auto& c : counts_) c.assign(size(), 0);
+  samples_ = 0;
+}
+
+size_t DensityMap::write(string fn, double t) {
+  DensityMapHeader h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, "LEVYMAP1", 8);
+  h.nx = (uint32_t)nx_; h.ny = (uint32_t)ny_; h.nz = (uint32_t)nz_;
+  h.maps = mapNumber;
+  h.lo[0] = lo_.X(); h.lo[1] = lo_.Y(); h.lo[2] = lo_.Z();
+  h.h = h_;
+  h.t = t;
+  h.samples = samples_;
+
+  // new file then rename - readers never see a partial map
+  string tmp = fn + ".tmp";
+  ofstream file(tmp.c_str(), ios::out|ios::binary|ios::trunc);
+  file.write((const char*)&h, sizeof(h));
+  for (auto& c : counts_) file.write((const char*)c.data(), c.size()*sizeof(uint64_t));
+
+  for (auto& c : counts_) {
+    // along z: (iy, ix), along y: (iz, ix), along x: (iz, iy)
+    size_t nxy = nx_*ny_, nxz = nx_*nz_, nyz = ny_*nz_;
+    proj_.assign(nxy + nxz + nyz, 0);
+    uint64_t* pz = proj_.data();
+    uint64_t* py = pz + nxy;
+    uint64_t* px = py + nxz;
+    for (long iz=0; iz < nz_; ++iz)
+      for (long iy=0; iy < ny_; ++iy)
+        for (long ix=0; ix < nx_; ++ix) {
+          uint64_t n = c[(iz*ny_ + iy)*nx_ + ix];
+          pz[iy*nx_ + ix] += n;
+          py[iz*nx_ + ix] += n;
+          px[iz*ny_ + iy] += n;
+        }
+    file.write((const char*)proj_.data(), proj_.size()*sizeof(uint64_t));
+  }
+  size_t bytes = (size_t)file.tellp();
+  file.close();
+  rename(tmp.c_str(), fn.c_str());
+  return bytes;
+}
+
+#endif
+
+// vim:foldmethod=syntax:foldlevel=0
@@ -0,0 +1,237 @@
+// Interactions.hpp
+// excluded volume interactions between walkers within and between clouds
+//
+// author: sungcheolkim @ IBM
+// date: 20261018 - initial version (Verlet list over cell list)
+//
+// after all clouds moved, overlapping pairs (distance < r_a + r_b) are pushed
+// apart along the center line, split by diffusion constant so fixed clouds do
+// not move. Hard resolves the full overlap, Soft moves by the harmonic force
+// D*dt*k*(sigma - d)/kT (never more than the overlap). pair candidates come
+// from a Verlet list (cutoff sigma + skin) built over a cell list and reused
+// until some walker has moved more than half of the skin.
+
+#ifndef INTERACTIONS_H
+#define INTERACTIONS_H
+
+#include <vector>
+#include <utility>
+#include "Vec3.hpp"
+#include "Log.hpp"
+#include "ParameterReader.h"
+#include "Cloud.hpp"
+#include "CellList.hpp"
+
+using namespace std;
+
+enum class InteractionTypeClass { hard, soft };
+
+struct InteractionPair {
+  Cloud* a;
+  Cloud* b;
+  double sigma;                               // contact distance [um]
+  CellList cl;                                // cell list of cloud b
+  vector<pair<uint32_t, uint32_t>> list;      // Verlet list (index in a, index in b)
+  vector<Vec3<double>> refA;                  // positions at last build
+  vector<Vec3<double>> refB;
+  size_t updateA;                             // add/remove count at last build
+  size_t updateB;
+  size_t moveA;                               // shift count at last build
+  size_t moveB;
+  size_t rebuild;
+  size_t overlap;
+};
+
+class Interactions {
+
+public:
+  // member functions
+  void addPair(Cloud* a, Cloud* b);
+  void apply(double dt);
+  void info();
+
+  // constructor
+  Interactions(ParameterReader& pr, vector<Cloud*>& clouds):
+    steps_(0)
+  {
+    cout << blu << "[Interactions] is initialized." << def << endl;
+
+    string type = pr.stringRead("interaction Type", "Hard");
+    if (type.find("Soft") != string::npos) {
+      itype_ = InteractionTypeClass::soft;
+      stiffness_ = pr.doubleRead("interaction Stiffness", "1.0")*1e6;   // [kT/nm2] -> [kT/um2]
+    } else {
+      itype_ = InteractionTypeClass::hard;
+      stiffness_ = 0.0;
+    }
+    skin_ = pr.doubleRead("interaction Skin", "5")/1000.0;      // [um]
+    iteration_ = pr.intRead("interaction Iteration", "2");
+
+    // pairs as (A-B, A-A)
+    for (auto s : pr.arrayRead("interaction Pairs", "(Enzyme-Enzyme)")) {
+      auto found = s.find("-");
+      if (found == string::npos) {
+        cerr << "... interaction pair format: (A-B, A-A) " << s << endl;
+        exit(1);
+      }
+      Cloud* a = nullptr;
+      Cloud* b = nullptr;
+      for (auto c : clouds) {
+        if (c->cloudID() == s.substr(0, found)) a = c;
+        if (c->cloudID() == s.substr(found+1)) b = c;
+      }
+      if ((a == nullptr) or (b == nullptr)) {
+        cerr << "... no cloud for interaction pair " << s << endl;
+        exit(1);
+      }
+      addPair(a, b);
+    }
+  }
+  virtual ~Interactions() { };
+
+  inline uint64_t checks() { return checks_; }
+
+private:
+  bool needRebuild(InteractionPair& ip);
+  void rebuild(InteractionPair& ip);
+  bool shift(Cloud* c, Walker* w, Vec3<double> dr);
+
+  InteractionTypeClass itype_;
+  double stiffness_;
+  double skin_;
+  size_t iteration_;
+  size_t steps_;
+  uint64_t checks_ = 0;          // pair distance tests
+  vector<InteractionPair> plist_;
+  vector<size_t> cells_;       // reusable buffer for neighbor cells
+};
+
+void Interactions::addPair(Cloud* a, Cloud* b) {
+  InteractionPair ip;
+  ip.a = a;
+  ip.b = b;
+  ip.sigma = a->r() + b->r();
+  ip.updateA = a->updateCount() + 1;
+  ip.updateB = b->updateCount() + 1;
+  ip.rebuild = 0;
+  ip.overlap = 0;
+
+  // grid covering both surfaces
+  Vec3<double> lo = b->sf()->minDimension();
+  Vec3<double> hi = b->sf()->maxDimension();
+  Vec3<double> lo2 = a->sf()->minDimension();
+  Vec3<double> hi2 = a->sf()->maxDimension();
+  lo.set(min(lo.X(), lo2.X()), min(lo.Y(), lo2.Y()), min(lo.Z(), lo2.Z()));
+  hi.set(max(hi.X(), hi2.X()), max(hi.Y(), hi2.Y()), max(hi.Z(), hi2.Z()));
+  ip.cl.setGrid(lo, hi, ip.sigma + skin_, b->size());
+
+  cout << "... add interaction " << a->cloudID() << "-" << b->cloudID()
+       << " sigma: " << gre << ip.sigma*1000.0 << def << " [nm] cell: " << ip.cl.h()*1000.0 << " [nm]" << endl;
+  plist_.push_back(ip);
+}
+
+bool Interactions::needRebuild(InteractionPair& ip) {
+  // walkers added or removed (reactions) change indices
+  if ((ip.updateA != ip.a->updateCount()) or (ip.updateB != ip.b->updateCount()))
+    return true;
+
+  // largest displacement since last build in each cloud (unshifted: none)
+  double maxA = 0.0, maxB = 0.0;
+  if (ip.moveA != ip.a->moveCount())
+    for (size_t i=0; i < ip.a->size(); ++i)
+      maxA = max(maxA, ((*ip.a)[i]->position() - ip.refA[i]).mag2());
+  if (ip.a == ip.b) maxB = maxA;
+  else if (ip.moveB != ip.b->moveCount())
+    for (size_t j=0; j < ip.b->size(); ++j)
+      maxB = max(maxB, ((*ip.b)[j]->position() - ip.refB[j]).mag2());
+
+  return (sqrt(maxA) + sqrt(maxB) > skin_);
+}
+
+void Interactions::rebuild(InteractionPair& ip) {
+  double cutoff2 = (ip.sigma + skin_)*(ip.sigma + skin_);
+  ip.cl.build(ip.b->wlist());
+  ip.list.clear();
+
+  for (size_t i=0; i < ip.a->size(); ++i) {
+    Vec3<double> p = (*ip.a)[i]->position();
+    ip.cl.neighborCells(p, cells_);
+    for (auto c : cells_)
+      for (uint32_t k=ip.cl.start(c); k < ip.cl.end(c); ++k) {
+        uint32_t j = ip.cl.item(k);
+        // count same cloud pairs once
+        if ((ip.a == ip.b) and (j <= i)) continue;
+        if (((*ip.b)[j]->position() - p).mag2() < cutoff2)
+          ip.list.push_back(make_pair((uint32_t)i, j));
+      }
+  }
+
+  ip.refA.resize(ip.a->size());
+  for (size_t i=0; i < ip.a->size(); ++i) ip.refA[i] = (*ip.a)[i]->position();
+  ip.refB.resize(ip.b->size());
+  for (size_t j=0; j < ip.b->size(); ++j) ip.refB[j] = (*ip.b)[j]->position();
+  ip.updateA = ip.a->updateCount();
+  ip.updateB = ip.b->updateCount();
+  ip.moveA = ip.a->moveCount();
+  ip.moveB = ip.b->moveCount();
+  ip.rebuild++;
+}
+
+bool Interactions::shift(Cloud* c, Walker* w, Vec3<double> dr) {
+  // keep walker inside surfaces and outside of obstacles
+  Vec3<double> p = w->position() + dr;
+  if (!c->sf()->isInside(p)) return false;
+  if ((c->obstacles() != nullptr) and c->obstacles()->isInside(p, c->r())) return false;
+
+  c->shiftWalker(w, dr);
+  return true;
+}
+
+void Interactions::apply(double dt) {
+  steps_++;
+
+  for (auto& ip : plist_) {
+    double Da = ip.a->isStatic() ? 0.0 : ip.a->D();
+    double Db = ip.b->isStatic() ? 0.0 : ip.b->D();
+    if (Da + Db == 0.0) continue;
+
+    if (needRebuild(ip)) rebuild(ip);
+
+    for (size_t k=0; k < iteration_; ++k) {
+      size_t count = 0;
+      checks_ += ip.list.size();
+      for (auto& pp : ip.list) {
+        Walker* wa = (*ip.a)[pp.first];
+        Walker* wb = (*ip.b)[pp.second];
+        Vec3<double> d = wb->position() - wa->position();
+        double dist = d.mag();
+        if (dist >= ip.sigma) continue;
+
+        double overlap = ip.sigma - dist;
+        if (itype_ == InteractionTypeClass::soft)
+          overlap = min(overlap, (Da + Db)*dt*stiffness_*overlap);
+        // coincident centers: push along x
+        if (dist > 0.0) d /= dist;
+        else d.set(1.0, 0.0, 0.0);
+
+        shift(ip.a, wa, d*(-overlap*Da/(Da + Db)));
+        shift(ip.b, wb, d*(overlap*Db/(Da + Db)));
+        count++;
+      }
+      ip.overlap += count;
+      if (count == 0) break;
+    }
+  }
+}
+
+void Interactions::info() {
+  for (auto& ip : plist_) {
+    cout << "Interaction " << ip.a->cloudID() << "-" << ip.b->cloudID()
+         << " Overlap: " << ip.overlap << " Verlet Pairs: " << ip.list.size()
+         << " Rebuild: " << ip.rebuild << "/" << steps_ << endl;
+  }
+}
+
+#endif
+
+// vim:foldmethod=syntax:foldlevel=0
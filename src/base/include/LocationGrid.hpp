@@ -0,0 +1,176 @@
+// LocationGrid.hpp
+// walker indices by uniform grid cell, kept up to date with each move
+//
+// author: sungcheolkim @ IBM
+// date: 20261018 - initial version (Amanatides-Woo segment traversal)
+//       20261018 - permute for reordered walkers
+//       20261018 - concurrent queries with caller buffers
+//       20261019 - cell geometry from UniformGrid
+//
+// cells are at least the search distance wide, so everything within that
+// distance of a segment lies in the 3x3x3 neighbourhood of a cell the
+// segment crosses. segmentItems walks the crossed cells with a 3D DDA and
+// writes the items of their neighbourhoods (each cell once) into a buffer
+// owned by the caller. positions outside the grid go to the border cells.
+// the query with a cell buffer leaves the grid untouched, so several threads
+// can search at once while nobody moves items.
+
+#ifndef LOCATIONGRID_H
+#define LOCATIONGRID_H
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <math.h>
+#include "Vec3.hpp"
+#include "UniformGrid.hpp"
+
+using namespace std;
+
+class LocationGrid : public UniformGrid {
+
+public:
+  // member functions
+  void setGrid(Vec3<double> lo, Vec3<double> hi, double h, size_t n);
+  void insert(size_t tid, Vec3<double> p);
+  void erase(size_t tid);
+  void move(size_t tid, Vec3<double> p);
+  void renumber(size_t from, size_t to);
+  void permute(const vector<uint32_t>& newTid);
+  void segmentItems(Vec3<double> p, Vec3<double> dr, vector<size_t>& list);
+  void segmentItems(Vec3<double> p, Vec3<double> dr, vector<size_t>& list, vector<size_t>& cells);
+
+  // constructor
+  LocationGrid(): UniformGrid(0.0), epoch_(0) { }
+  virtual ~LocationGrid() { };
+
+  // inline functions
+  inline bool on() { return h_ > 0.0; }
+
+private:
+  void addNeighborhood(long ix, long iy, long iz, vector<size_t>& list);
+  template <class F> void traverse(Vec3<double> p, Vec3<double> dr, F visit);
+
+  vector<vector<uint32_t>> items_;    // tids in cell
+  vector<uint32_t> cell_;             // cell of tid
+  vector<uint32_t> stamp_;            // last query that listed cell
+  uint32_t epoch_;
+};
+
+void LocationGrid::setGrid(Vec3<double> lo, Vec3<double> hi, double h, size_t n) {
+  UniformGrid::setGrid(lo, hi, h, n);
+  items_.assign(cellNumber(), vector<uint32_t>{});
+  stamp_.assign(cellNumber(), 0);
+  cell_.clear();
+  epoch_ = 0;
+}
+
+void LocationGrid::insert(size_t tid, Vec3<double> p) {
+  if (cell_.size() <= tid) cell_.resize(tid+1);
+  cell_[tid] = cellOf(p);
+  items_[cell_[tid]].push_back(tid);
+}
+
+void LocationGrid::erase(size_t tid) {
+  auto& v = items_[cell_[tid]];
+  auto it = find(v.begin(), v.end(), (uint32_t)tid);
+  *it = v.back();
+  v.pop_back();
+}
+
+void LocationGrid::move(size_t tid, Vec3<double> p) {
+  uint32_t c = cellOf(p);
+  if (c == cell_[tid]) return;
+  erase(tid);
+  cell_[tid] = c;
+  items_[c].push_back(tid);
+}
+
+void LocationGrid::renumber(size_t from, size_t to) {
+  // last walker takes the index of a removed one
+  auto& v = items_[cell_[from]];
+  *find(v.begin(), v.end(), (uint32_t)from) = to;
+  cell_[to] = cell_[from];
+}
+
+void LocationGrid::permute(const vector<uint32_t>& newTid) {
+  // all walkers took new indices, cells stay
+  for (auto& v : items_)
+    for (auto& t : v) t = newTid[t];
+  vector<uint32_t> old(cell_);
+  for (size_t t=0; t < newTid.size(); ++t) cell_[newTid[t]] = old[t];
+}
+
+void LocationGrid::addNeighborhood(long ix, long iy, long iz, vector<size_t>& list) {
+  for (long kz=max(iz-1, 0L); kz <= min(iz+1, nz_-1); ++kz)
+    for (long ky=max(iy-1, 0L); ky <= min(iy+1, ny_-1); ++ky)
+      for (long kx=max(ix-1, 0L); kx <= min(ix+1, nx_-1); ++kx) {
+        size_t c = (kz*ny_ + ky)*nx_ + kx;
+        if (stamp_[c] == epoch_) continue;
+        stamp_[c] = epoch_;
+        for (auto t : items_[c]) list.push_back(t);
+      }
+}
+
+template <class F>
+void LocationGrid::traverse(Vec3<double> p, Vec3<double> dr, F visit) {
+  double a[3] = {(p.X()-lo_.X())/h_, (p.Y()-lo_.Y())/h_, (p.Z()-lo_.Z())/h_};
+  double d[3] = {dr.X()/h_, dr.Y()/h_, dr.Z()/h_};
+  long n[3] = {nx_, ny_, nz_};
+  long i[3], step[3], left[3];
+  double tMax[3], tDelta[3];
+
+  // cells of both ends, then steps along each axis between them
+  for (int k=0; k < 3; ++k) {
+    i[k] = clamp(a[k], n[k]);
+    long e = clamp(a[k] + d[k], n[k]);
+    step[k] = (e > i[k]) ? 1 : -1;
+    left[k] = labs(e - i[k]);
+    if (d[k] != 0.0) {
+      double face = (step[k] > 0) ? (double)(i[k] + 1) : (double)i[k];
+      tMax[k] = (face - a[k])/d[k];
+      tDelta[k] = fabs(1.0/d[k]);
+    } else {
+      tMax[k] = HUGE_VAL;
+      tDelta[k] = HUGE_VAL;
+    }
+  }
+
+  visit(i[0], i[1], i[2]);
+  while (left[0] + left[1] + left[2] > 0) {
+    // next face crossing among axes with steps left
+    int k = -1;
+    for (int j=0; j < 3; ++j)
+      if ((left[j] > 0) and ((k < 0) or (tMax[j] < tMax[k]))) k = j;
+    i[k] += step[k];
+    tMax[k] += tDelta[k];
+    left[k]--;
+    visit(i[0], i[1], i[2]);
+  }
+}
+
+void LocationGrid::segmentItems(Vec3<double> p, Vec3<double> dr, vector<size_t>& list) {
+  list.clear();
+  if (++epoch_ == 0) { fill(stamp_.begin(), stamp_.end(), 0); epoch_ = 1; }
+  traverse(p, dr, [&](long ix, long iy, long iz) { addNeighborhood(ix, iy, iz, list); });
+}
+
+void LocationGrid::segmentItems(Vec3<double> p, Vec3<double> dr, vector<size_t>& list, vector<size_t>& cells) {
+  // neighbourhood cells of the crossed cells, each once, without stamps
+  list.clear();
+  cells.clear();
+  traverse(p, dr, [&](long ix, long iy, long iz) {
+    for (long kz=max(iz-1, 0L); kz <= min(iz+1, nz_-1); ++kz)
+      for (long ky=max(iy-1, 0L); ky <= min(iy+1, ny_-1); ++ky)
+        for (long kx=max(ix-1, 0L); kx <= min(ix+1, nx_-1); ++kx)
+          cells.push_back((kz*ny_ + ky)*nx_ + kx);
+  });
+  sort(cells.begin(), cells.end());
+  cells.erase(unique(cells.begin(), cells.end()), cells.end());
+  for (auto c : cells)
+    for (auto t : items_[c]) list.push_back(t);
+}
+
+#endif
+
+// vim:foldmethod=syntax:foldlevel=0
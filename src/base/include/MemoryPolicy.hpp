@@ -0,0 +1,219 @@
+// MemoryPolicy.hpp
+// page backing and node placement of large arrays
+//
+// author: sungcheolkim @ IBM
+// date: 20261018 - initial version (huge pages, partitioned first touch)
+// date: 20261019 - pool blocks rounded up to whole huge pages
+//
+// blocks of at least half a huge page are mapped on their own and aligned to
+// 2 MB; pools ask blockSlots for blocks that fill whole huge pages, so their
+// growth blocks are mapped as well. Madvise asks for transparent huge pages,
+// Hugetlb for pages of the reserved pool (falls back to Madvise when none are
+// left). with a toucher pool, thread t writes the t-th share of every block
+// before anyone else, so the kernel puts those pages on the node of thread t;
+// the shares match the first ranges of TaskPool::parallelFor over walkers in
+// tid order. placement() reads huge page bytes from /proc/self/smaps and the
+// node of sampled pages from move_pages.
+
+#ifndef MEMORYPOLICY_H
+#define MEMORYPOLICY_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <new>
+#include "TaskPool.hpp"
+
+using namespace std;
+
+struct MemoryBlock {
+  void* p = nullptr;
+  size_t bytes = 0;
+  size_t mapped = 0;            // mmap length, 0: posix_memalign
+};
+
+struct MemoryPlacement {
+  size_t bytes = 0;
+  size_t hugeBytes = 0;
+  vector<size_t> nodePages;     // sampled pages per node
+  size_t unknownPages = 0;      // not touched or no answer
+  string str();
+};
+
+enum class HugePages { Off, Madvise, Hugetlb };
+
+class MemoryPolicy {
+
+public:
+  // member functions
+  MemoryBlock allocate(size_t bytes, size_t alignment);
+  size_t blockSlots(size_t slots, size_t slotSize);
+  static MemoryBlock plain(size_t bytes, size_t alignment);
+  static void release(MemoryBlock& b);
+  static void placement(const MemoryBlock& b, MemoryPlacement& mp);
+  static size_t nodeNumber();
+  string str();
+
+  // constructor
+  MemoryPolicy(): huge_(HugePages::Off), toucher_(nullptr) { }
+  virtual ~MemoryPolicy() { };
+
+  // inline functions
+  inline HugePages huge() { return huge_; }
+  inline void huge(HugePages h) { huge_ = h; }
+  inline TaskPool* toucher() { return toucher_; }
+  inline void toucher(TaskPool* p) { toucher_ = p; }
+  inline bool touch() { return (toucher_ != nullptr) and (toucher_->threads() > 1); }
+  inline bool active() { return (huge_ != HugePages::Off) or touch(); }
+
+  static const size_t hugePage_ = 2u << 20;
+
+private:
+  void firstTouch(char* p, size_t bytes);
+
+  HugePages huge_;
+  TaskPool* toucher_;
+};
+
+MemoryBlock MemoryPolicy::plain(size_t bytes, size_t alignment) {
+  MemoryBlock b;
+  if (posix_memalign(&b.p, alignment, bytes) != 0) throw bad_alloc{};
+  b.bytes = bytes;
+  return b;
+}
+
+MemoryBlock MemoryPolicy::allocate(size_t bytes, size_t alignment) {
+  // small blocks or nothing to do: heap
+  if ((bytes < hugePage_/2) or !active())
+    return plain(bytes, alignment);
+
+  MemoryBlock b;
+  b.bytes = bytes;
+  size_t len = (bytes + hugePage_ - 1)/hugePage_*hugePage_;
+  if (huge_ == HugePages::Hugetlb) {
+    void* p = mmap(nullptr, len, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) {
+      b.p = p;
+      b.mapped = len;
+    } else {
+      cout << "... memory: no hugetlb pages for " << len/1024 << " [kB], use madvise" << endl;
+      huge_ = HugePages::Madvise;
+    }
+  }
+  if (b.p == nullptr) {
+    // one huge page extra to cut an aligned range out of
+    char* p = (char*)mmap(nullptr, len + hugePage_, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if (p == (char*)MAP_FAILED) throw bad_alloc{};
+    char* a = (char*)(((uintptr_t)p + hugePage_ - 1)/hugePage_*hugePage_);
+    if (a > p) munmap(p, a - p);
+    if (a + len < p + len + hugePage_) munmap(a + len, p + len + hugePage_ - (a + len));
+    if (huge_ == HugePages::Madvise) madvise(a, len, MADV_HUGEPAGE);
+    b.p = a;
+    b.mapped = len;
+  }
+  if (touch()) firstTouch((char*)b.p, len);
+  return b;
+}
+
+size_t MemoryPolicy::blockSlots(size_t slots, size_t slotSize) {
+  // slots of the whole huge pages a block is mapped on (at least one)
+  if (!active()) return slots;
+  size_t len = (slots*slotSize + hugePage_ - 1)/hugePage_*hugePage_;
+  return len/slotSize;
+}
+
+void MemoryPolicy::firstTouch(char* p, size_t bytes) {
+  // share of thread t in huge page units, so no page is split between nodes
+  size_t units = bytes/hugePage_;
+  size_t n = toucher_->threads();
+  toucher_->each([p, units, n](size_t t) {
+    size_t b = units*t/n, e = units*(t+1)/n;
+    if (e > b) memset(p + b*hugePage_, 0, (e - b)*hugePage_);
+  });
+}
+
+void MemoryPolicy::release(MemoryBlock& b) {
+  if (b.p == nullptr) return;
+  if (b.mapped > 0) munmap(b.p, b.mapped);
+  else free(b.p);
+  b = MemoryBlock{};
+}
+
+void MemoryPolicy::placement(const MemoryBlock& b, MemoryPlacement& mp) {
+  mp.bytes += b.bytes;
+  uintptr_t lo = (uintptr_t)b.p, hi = lo + b.bytes;
+
+  // huge pages of the mappings that overlap the block
+  ifstream f("/proc/self/smaps");
+  string line;
+  bool in = false;
+  size_t huge = 0;
+  while (getline(f, line)) {
+    uintptr_t s, e;
+    if (sscanf(line.c_str(), "%lx-%lx ", &s, &e) == 2) { in = (s < hi) and (e > lo); continue; }
+    size_t kb;
+    if (in and (sscanf(line.c_str(), "AnonHugePages: %zu kB", &kb) == 1)) huge += kb*1024;
+  }
+  mp.hugeBytes += min(huge, b.bytes);
+
+  // node of up to 256 pages spread over the block
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  size_t pages = max((size_t)1, b.bytes/page);
+  size_t n = min(pages, (size_t)256);
+  vector<void*> addr(n);
+  vector<int> status(n, -1);
+  for (size_t i=0; i < n; ++i) addr[i] = (char*)b.p + (pages*i/n)*page;
+  if (syscall(SYS_move_pages, 0, n, addr.data(), nullptr, status.data(), 0) != 0) {
+    mp.unknownPages += n;
+    return;
+  }
+  for (auto s : status) {
+    if (s < 0) { mp.unknownPages++; continue; }
+    if (mp.nodePages.size() <= (size_t)s) mp.nodePages.resize(s+1, 0);
+    mp.nodePages[s]++;
+  }
+}
+
+size_t MemoryPolicy::nodeNumber() {
+  size_t n = 0;
+  DIR* d = opendir("/sys/devices/system/node");
+  if (d == nullptr) return 1;
+  while (dirent* e = readdir(d)) {
+    int k;
+    if (sscanf(e->d_name, "node%d", &k) == 1) n++;
+  }
+  closedir(d);
+  return max(n, (size_t)1);
+}
+
+string MemoryPolicy::str() {
+  ostringstream os;
+  os << "huge pages " << ((huge_ == HugePages::Hugetlb) ? "hugetlb" : (huge_ == HugePages::Madvise) ? "madvise" : "off")
+     << ", first touch on " << (toucher_ != nullptr ? toucher_->threads() : 1) << " thread(s), "
+     << nodeNumber() << " node(s)";
+  return os.str();
+}
+
+string MemoryPlacement::str() {
+  ostringstream os;
+  os << bytes/1024 << " [kB], huge " << hugeBytes/1024 << " [kB], nodes";
+  size_t sampled = unknownPages;
+  for (auto c : nodePages) sampled += c;
+  for (size_t k=0; k < nodePages.size(); ++k)
+    if (nodePages[k] > 0) os << " " << k << ":" << 100*nodePages[k]/max(sampled, (size_t)1) << "%";
+  if (unknownPages > 0) os << " ?:" << 100*unknownPages/max(sampled, (size_t)1) << "%";
+  return os.str();
+}
+
+#endif
+
+// vim:foldmethod=syntax:foldlevel=0
@@ -0,0 +1,154 @@
+// MultiRun.hpp
+// many simulators in one run, stepped together on a task pool
+//
+// author: sungcheolkim @ IBM
+// date: 20261019 - initial version (from Population and Sweep)
+//
+// every run is a Simulator on its own copy of the parameter file, with its own
+// seed and file names. runs never interact, so they are the parallel unit:
+// cloud and walker threads are off inside a run and the runs step together on
+// "<name> Threads" threads (0: all cores). setup messages are shown for the
+// first run only unless "<name> Verbose" is set. derived classes set their
+// parameters on each copy, report products every info cycle, and may sample
+// after every step.
+
+#ifndef MULTIRUN_H
+#define MULTIRUN_H
+
+#include "Simulator.hpp"
+#include "TaskPool.hpp"
+
+using namespace std;
+
+class MultiRun {
+
+public:
+  // member functions
+  ParameterReader* copyParameters(ParameterReader& pr, string suffix, unsigned long int seed);
+  void addRun(ParameterReader* p);
+  void startRuns();
+  void run();
+  virtual void sample(size_t) { }
+  virtual void report(bool last) = 0;
+
+  // constructor
+  MultiRun(ParameterReader& pr, Log* lg, string name, string unit):
+    log_(lg), name_(name), unit_(unit), pool_(nullptr)
+  {
+    threads_ = pr.intRead(name + " Threads", "0", false);
+    if (threads_ == 0) threads_ = max(1u, thread::hardware_concurrency());
+    verbose_ = pr.boolRead(name + " Verbose", "False", false);
+
+    iteration_ = pr.intRead("iteration", "1000", false);
+    infoCycle_ = pr.intRead("info Cycle", "100", false);
+    seed_ = stoul(pr.stringRead("seed", "0", false));
+    if (seed_ == 0) {
+      struct timeval tv;
+      gettimeofday(&tv, 0);
+      seed_ = tv.tv_sec+tv.tv_usec;
+    }
+
+    string tmp = pr.simfilename();
+    baseName_ = (tmp.find(".par") != string::npos) ? tmp.substr(0, tmp.find(".par")) : tmp;
+    saveName_ = baseName_ + "_" + name + ".txt";
+  }
+  MultiRun(const MultiRun& m) = delete;
+  MultiRun& operator=(const MultiRun& m) = delete;
+  virtual ~MultiRun() {
+    if (pool_ != nullptr) delete pool_;
+    for (auto s : runs_) delete s;
+    for (auto p : prs_) delete p;
+  }
+
+  // inline functions
+  inline size_t runNumber() { return runs_.size(); }
+  inline Simulator* runOf(size_t k) { return runs_[k]; }
+  // i-th cloud with substrate of run k
+  inline CloudCell* product(size_t k, size_t i) { return dynamic_cast<CloudCell*>(runs_[k]->cloudList()[productClouds_[i]]); }
+  inline string productID(size_t i) { return runs_[0]->cloudList()[productClouds_[i]]->cloudID(); }
+  // i with leading zeros to width digits
+  inline string numbered(size_t i, size_t width) {
+    string s = to_string(i);
+    return string((s.size() < width) ? width - s.size() : 0, '0') + s;
+  }
+
+protected:
+  Log* log_;
+  string name_;
+  string unit_;
+  size_t threads_;
+  bool verbose_;
+  size_t iteration_;
+  size_t infoCycle_;
+  unsigned long int seed_;
+  string baseName_;
+  string saveName_;
+
+  vector<ParameterReader*> prs_;
+  vector<Simulator*> runs_;
+  vector<size_t> productClouds_;    // clouds with substrate (same in all runs)
+  TaskPool* pool_;
+  vector<function<void()>> tasks_;
+};
+
+ParameterReader* MultiRun::copyParameters(ParameterReader& pr, string suffix, unsigned long int seed) {
+  // copy of the first run keeps its defaults, so they are added once
+  ParameterReader* p = new ParameterReader(prs_.empty() ? pr : *prs_[0]);
+  p->saveOnExit(false);
+  p->simfilename(baseName_ + suffix + ".par");
+  p->set("seed", to_string(seed));
+  p->set("show Progress", "False");
+  // runs are the parallel unit
+  p->set("cloud Threads", "1");
+  p->set("walker Threads", "0");
+  return p;
+}
+
+void MultiRun::addRun(ParameterReader* p) {
+  prs_.push_back(p);
+
+  streambuf* out = cout.rdbuf();
+  if (!runs_.empty() and !verbose_) cout.rdbuf(nullptr);
+  Simulator* s = new Simulator{*p, log_};
+  s->injectClouds(*p);
+  cout.rdbuf(out);
+  runs_.push_back(s);
+}
+
+void MultiRun::startRuns() {
+  for (size_t i=0; i < runs_[0]->cloudList().size(); ++i)
+    if (dynamic_cast<CloudCell*>(runs_[0]->cloudList()[i]) and (runs_[0]->cloudList()[i]->rateStatistics() != nullptr))
+      productClouds_.push_back(i);
+
+  for (size_t k=0; k < runs_.size(); ++k)
+    tasks_.push_back([this, k] {
+      runs_[k]->evolveClouds();
+      runs_[k]->writeClouds();
+    });
+  pool_ = new TaskPool(min(threads_, runs_.size()));
+}
+
+void MultiRun::run() {
+  high_resolution_clock::time_point t1 = high_resolution_clock::now();
+  log_->timestamp(name_ + ": " + to_string(runs_.size()) + " " + unit_ + ", iteration: " + to_string(iteration_) + " [Start]");
+
+  size_t itr;
+  for (itr=0; itr < iteration_; ++itr) {
+    pool_->run(tasks_);
+    sample(itr+1);
+    if ((itr%infoCycle_) == 0) {
+      auto sec = duration<double>(high_resolution_clock::now() - t1).count();
+      cout << blu << "[#] = " << itr << " " << string(60, '-') << " " << (long)sec << " [sec] " << def << endl;
+      report(false);
+    }
+  }
+
+  auto sec = duration<double>(high_resolution_clock::now() - t1).count();
+  cout << blu << "[#] = " << itr << " " << string(35, '-') << " running time: " << sec << " [secs]" << def << endl;
+  report(true);
+  log_->timestamp(name_ + " [End]");
+}
+
+#endif
+
+// vim:foldmethod=syntax:foldlevel=0
@@ -0,0 +1,422 @@
+// Obstacles.hpp
+// static spherical obstacles (macromolecular crowding) inside Surfaces
+//
+// author: sungcheolkim @ IBM
+// date: 20261018 - initial version (packed grid index)
+// date: 20261018 - hit count shared by concurrent clouds
+// date: 20261019 - obstacle id of the nearest hit over all cells
+//
+// obstacles are placed once (from file, or fcc lattice relaxed by hard sphere
+// Monte Carlo) and never move. the index is a packed uniform grid (CSR layout)
+// where each obstacle is registered in every cell its bounding box (obstacle
+// radius + margin) overlaps. margin is the largest walker radius, so a swept
+// segment only visits the cells it passes through (3D DDA).
+
+#ifndef OBSTACLES_H
+#define OBSTACLES_H
+
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_const_num.h>
+#include <vector>
+#include <cstdint>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include "Vec3.hpp"
+#include "ParameterReader.h"
+#include "Surfaces.hpp"
+#include "SurfacesSphere.hpp"
+#include "SurfacesBox.hpp"
+#include "SurfacesCell.hpp"
+
+using namespace std;
+
+struct Obstacle {
+  double x, y, z, r;
+};
+
+class Obstacles {
+
+public:
+  // member functions
+  void injectObstacles(ParameterReader& pr, gsl_rng* rs);
+  void readObstacles(string fn);
+  void writeObstacles(string fn);
+  void buildIndex();
+  bool isInside(Vec3<double> p, double rw);
+  double getTimeForObstacle(Vec3<double> p, Vec3<double> dr, double rw, size_t& oid);
+  size_t calNewStep(Vec3<double> p, Vec3<double> dr, double rw, vector<Vec3<double>>& legs);
+
+  // constructor
+  Obstacles(ParameterReader& pr, string oID, double margin):
+    obstacleID_(oID),
+    margin_(margin),
+    hitCount_(0)
+  {
+    cout << blu << "[Obstacles(" << oID << ")] is initialized." << def << endl;
+
+    string shape = pr.stringRead(oID+" Surface Shape", "Cell");
+    if (shape.find("Sphere") != string::npos) {
+      sf_ = new SurfacesSphere{pr, oID};
+    } else if (shape.find("Box") != string::npos) {
+      sf_ = new SurfacesBox{pr, oID};
+    } else if (shape.find("Cell") != string::npos) {
+      sf_ = new SurfacesCell{pr, oID};
+    } else {
+      cerr << "... not know surface shape type: " << shape << " from (Sphere, Box, Cell)" << endl;
+      exit(1);
+    }
+
+    r_ = pr.doubleRead(oID+" Particle Radius", "5")/1000.0;     // [um]
+    maxReflection_ = pr.intRead(oID+" Max Reflection", "16");
+  }
+  virtual ~Obstacles() { delete sf_; };
+
+  // inline functions
+  inline size_t size() { return olist_.size(); }
+  inline Obstacle& operator[](size_t i) { return olist_[i]; }
+  inline double r() { return r_; }
+  inline double margin() { return margin_; }
+  inline Surfaces* sf() { return sf_; }
+  inline size_t hitCount() { return hitCount_; }
+  inline double volumeFraction() {
+    double v = 0;
+    for (auto& o : olist_) v += 4.0/3.0*M_PI*o.r*o.r*o.r;
+    return v/sf_->volume();
+  }
+
+private:
+  inline size_t cellIndex(long ix, long iy, long iz) { return (size_t)((iz*ny_ + iy)*nx_ + ix); }
+  inline long clampCell(double v, long n) { return min(max((long)floor(v), 0L), n-1); }
+  double hitSphere(const Obstacle& o, Vec3<double> p, Vec3<double> dr, double rw);
+  double checkCell(size_t cid, Vec3<double> p, Vec3<double> dr, double rw, size_t& oid);
+
+  string obstacleID_;
+  Surfaces* sf_;
+  vector<Obstacle> olist_;
+  double r_;
+  double margin_;
+  size_t maxReflection_;
+  atomic<size_t> hitCount_;      // clouds of different groups add concurrently
+
+  // packed grid: items of cell c are cellItems_[cellStart_[c] .. cellStart_[c+1])
+  Vec3<double> lo_;
+  Vec3<double> hi_;
+  double h_;
+  long nx_, ny_, nz_;
+  vector<uint32_t> cellStart_;
+  vector<uint32_t> cellItems_;
+};
+
+void Obstacles::injectObstacles(ParameterReader& pr, gsl_rng* rs) {
+  if (pr.checkName(obstacleID_+" File")) {
+    readObstacles(pr.stringRead(obstacleID_+" File", "obstacles.txt"));
+  } else {
+    double fraction = pr.doubleRead(obstacleID_+" Volume Fraction", "0.1");
+    size_t target = (size_t)(fraction*sf_->volume()/(4.0/3.0*M_PI*r_*r_*r_));
+    size_t sweep = pr.intRead(obstacleID_+" MC Sweep", "20");
+    cout << "... cal Obstacle Number: " << gre << target << def << endl;
+
+    // start from fcc lattice - random sequential addition jams far below 30%
+    Vec3<double> lo = sf_->minDimension();
+    Vec3<double> hi = sf_->maxDimension();
+    double a = pow(4.0*sf_->volume()/max(target, (size_t)1), 1.0/3.0);
+    const double basis[4][3] = {{0, 0, 0}, {0.5, 0.5, 0}, {0.5, 0, 0.5}, {0, 0.5, 0.5}};
+    vector<Vec3<double>> sites;
+    do {
+      sites.clear();
+      for (double x=lo.X(); x < hi.X(); x += a)
+        for (double y=lo.Y(); y < hi.Y(); y += a)
+          for (double z=lo.Z(); z < hi.Z(); z += a)
+            for (auto& b : basis) {
+              Vec3<double> p{x+b[0]*a, y+b[1]*a, z+b[2]*a};
+              if (sf_->isInside(p)) sites.push_back(p);
+            }
+      a *= 0.98;
+    } while ((sites.size() < target) and (a > 2.0*sqrt(2.0)*r_));
+
+    if (sites.size() < target) {
+      cout << red << "... obstacle packing is limited to " << sites.size() << "/" << target << def << endl;
+      target = sites.size();
+    }
+
+    // random subset of lattice sites
+    for (size_t i=0; i < target; ++i) {
+      size_t j = i + gsl_rng_uniform_int(rs, sites.size()-i);
+      swap(sites[i], sites[j]);
+      olist_.push_back(Obstacle{sites[i].X(), sites[i].Y(), sites[i].Z(), r_});
+    }
+
+    // hard sphere Monte Carlo sweeps with a temporary grid (cell = 2r)
+    double h = 2.0*r_;
+    long gx = max(1L, (long)ceil((hi.X()-lo.X())/h));
+    long gy = max(1L, (long)ceil((hi.Y()-lo.Y())/h));
+    long gz = max(1L, (long)ceil((hi.Z()-lo.Z())/h));
+    auto cellOf = [&](double x, double y, double z) {
+      long ix = min(max((long)floor((x-lo.X())/h), 0L), gx-1);
+      long iy = min(max((long)floor((y-lo.Y())/h), 0L), gy-1);
+      long iz = min(max((long)floor((z-lo.Z())/h), 0L), gz-1);
+      return (iz*gy + iy)*gx + ix;
+    };
+    vector<vector<uint32_t>> grid(gx*gy*gz);
+    for (size_t i=0; i < olist_.size(); ++i)
+      grid[cellOf(olist_[i].x, olist_[i].y, olist_[i].z)].push_back(i);
+
+    size_t accept = 0;
+    for (size_t k=0; k < sweep; ++k) {
+      for (size_t i=0; i < olist_.size(); ++i) {
+        Obstacle& o = olist_[i];
+        Vec3<double> p{o.x + r_*(2.0*gsl_rng_uniform(rs)-1.0),
+                       o.y + r_*(2.0*gsl_rng_uniform(rs)-1.0),
+                       o.z + r_*(2.0*gsl_rng_uniform(rs)-1.0)};
+        if (!sf_->isInside(p)) continue;
+
+        long c = cellOf(p.X(), p.Y(), p.Z());
+        long iz = c/(gx*gy), iy = (c/gx)%gy, ix = c%gx;
+        bool overlap = false;
+        for (long kz=max(iz-1, 0L); kz <= min(iz+1, gz-1) and !overlap; ++kz)
+          for (long ky=max(iy-1, 0L); ky <= min(iy+1, gy-1) and !overlap; ++ky)
+            for (long kx=max(ix-1, 0L); kx <= min(ix+1, gx-1) and !overlap; ++kx)
+              for (auto j : grid[(kz*gy + ky)*gx + kx]) {
+                if (j == i) continue;
+                Vec3<double> d{p.X()-olist_[j].x, p.Y()-olist_[j].y, p.Z()-olist_[j].z};
+                if (d.mag2() < 4.0*r_*r_) { overlap = true; break; }
+              }
+        if (overlap) continue;
+
+        // move obstacle between cells
+        long c0 = cellOf(o.x, o.y, o.z);
+        if (c0 != c) {
+          auto& v = grid[c0];
+          v.erase(find(v.begin(), v.end(), (uint32_t)i));
+          grid[c].push_back(i);
+        }
+        o.x = p.X(); o.y = p.Y(); o.z = p.Z();
+        accept++;
+      }
+    }
+    if (sweep > 0)
+      cout << "... cal Obstacle MC Acceptance: " << gre << (double)accept/(sweep*max(olist_.size(), (size_t)1)) << def << endl;
+  }
+  cout << "... inject " << gre << olist_.size() << def << " Obstacles in (" << obstacleID_ << ")" << endl;
+  cout << "... cal Obstacle Volume Fraction: " << gre << volumeFraction() << def << endl;
+
+  if (pr.boolRead(obstacleID_+" Save", "False")) {
+    string tmp = pr.simfilename();
+    writeObstacles(tmp.substr(0, tmp.find(".par")) + "_" + obstacleID_ + ".pt");
+  }
+
+  buildIndex();
+}
+
+void Obstacles::readObstacles(string fn) {
+  ifstream infile(fn.c_str());
+  if (!infile.good()) {
+    cerr << "... " << fn << " does not exist." << endl;
+    exit(1);
+  }
+  cout << "... read obstacles from " << fn << endl;
+
+  // format: x y z [r] in [um], '#' for comment
+  for (string line; getline(infile, line); ) {
+    if (line.empty() or line.find("#") == 0) continue;
+    istringstream iss(line);
+    Obstacle o{0.0, 0.0, 0.0, r_};
+    if (!(iss >> o.x >> o.y >> o.z)) continue;
+    iss >> o.r;
+    olist_.push_back(o);
+  }
+}
+
+void Obstacles::writeObstacles(string fn) {
+  cout << "... save obstacle positions: " << fn << endl;
+  ofstream outfile(fn.c_str());
+  outfile << "x y z r" << endl;
+  for (auto& o : olist_)
+    outfile << o.x << " " << o.y << " " << o.z << " " << o.r << endl;
+}
+
+void Obstacles::buildIndex() {
+  double rmax = r_;
+  for (auto& o : olist_) rmax = max(rmax, o.r);
+
+  // cell is as large as one inflated obstacle, so each one covers at most 8 cells
+  h_ = 2.0*(rmax + margin_);
+  Vec3<double> pad{rmax+margin_, rmax+margin_, rmax+margin_};
+  lo_ = sf_->minDimension() - pad;
+  hi_ = sf_->maxDimension() + pad;
+  Vec3<double> ext = hi_ - lo_;
+  nx_ = max(1L, (long)ceil(ext.X()/h_));
+  ny_ = max(1L, (long)ceil(ext.Y()/h_));
+  nz_ = max(1L, (long)ceil(ext.Z()/h_));
+
+  // counting sort into packed arrays: pass 0 counts, pass 1 fills
+  cellStart_.assign(nx_*ny_*nz_+1, 0);
+  vector<uint32_t> fill;
+  for (int pass=0; pass < 2; ++pass) {
+    for (size_t i=0; i < olist_.size(); ++i) {
+      Obstacle& o = olist_[i];
+      double e = o.r + margin_;
+      long x0 = clampCell((o.x-e-lo_.X())/h_, nx_), x1 = clampCell((o.x+e-lo_.X())/h_, nx_);
+      long y0 = clampCell((o.y-e-lo_.Y())/h_, ny_), y1 = clampCell((o.y+e-lo_.Y())/h_, ny_);
+      long z0 = clampCell((o.z-e-lo_.Z())/h_, nz_), z1 = clampCell((o.z+e-lo_.Z())/h_, nz_);
+      for (long iz=z0; iz <= z1; ++iz)
+        for (long iy=y0; iy <= y1; ++iy)
+          for (long ix=x0; ix <= x1; ++ix) {
+            size_t c = cellIndex(ix, iy, iz);
+            if (pass == 0) cellStart_[c+1]++;
+            else cellItems_[fill[c]++] = i;
+          }
+    }
+    if (pass == 0) {
+      for (size_t c=0; c+1 < cellStart_.size(); ++c) cellStart_[c+1] += cellStart_[c];
+      cellItems_.resize(cellStart_.back());
+      fill.assign(cellStart_.begin(), cellStart_.end()-1);
+    }
+  }
+
+  cout << "... build obstacle grid: " << nx_ << "x" << ny_ << "x" << nz_
+       << " cell: " << h_*1000.0 << " [nm] entries: " << cellItems_.size() << endl;
+}
+
+bool Obstacles::isInside(Vec3<double> p, double rw) {
+  if (olist_.empty()) return false;
+  size_t c = cellIndex(clampCell((p.X()-lo_.X())/h_, nx_),
+                       clampCell((p.Y()-lo_.Y())/h_, ny_),
+                       clampCell((p.Z()-lo_.Z())/h_, nz_));
+  for (uint32_t k=cellStart_[c]; k < cellStart_[c+1]; ++k) {
+    Obstacle& o = olist_[cellItems_[k]];
+    Vec3<double> d{p.X()-o.x, p.Y()-o.y, p.Z()-o.z};
+    if (d.mag2() < (o.r+rw)*(o.r+rw)) return true;
+  }
+  return false;
+}
+
+double Obstacles::hitSphere(const Obstacle& o, Vec3<double> p, Vec3<double> dr, double rw) {
+  // solve |p + t dr - c|^2 = (r + rw)^2 for the entering root
+  Vec3<double> m{p.X()-o.x, p.Y()-o.y, p.Z()-o.z};
+  double R = o.r + rw;
+  double b = m.dotProduct(dr);
+  double f = m.mag2() - R*R;
+
+  // starting on (or inside) the sphere: only moving inward is a hit
+  if (f <= 0.0) return (b < 0.0) ? 0.0 : 2.0;
+  // moving away
+  if (b >= 0.0) return 2.0;
+
+  double a = dr.mag2();
+  double disc = b*b - a*f;
+  if (disc < 0.0) return 2.0;
+
+  double t = (-b - sqrt(disc))/a;
+  return (t <= 1.0) ? t : 2.0;
+}
+
+double Obstacles::checkCell(size_t cid, Vec3<double> p, Vec3<double> dr, double rw, size_t& oid) {
+  double min_t = 2.0;
+  for (uint32_t k=cellStart_[cid]; k < cellStart_[cid+1]; ++k) {
+    double t = hitSphere(olist_[cellItems_[k]], p, dr, rw);
+    if (t < min_t) { min_t = t; oid = cellItems_[k]; }
+  }
+  return min_t;
+}
+
+double Obstacles::getTimeForObstacle(Vec3<double> p, Vec3<double> dr, double rw, size_t& oid) {
+  // particle position: p
+  // movement vector: dr
+  // output: number tt - p+tt*dr touches obstacle oid, tt = 2.0 for no hit
+
+  if (olist_.empty() or dr.mag2() == 0.0) return 2.0;
+
+  // clip segment to grid box
+  double t0 = 0.0, t1 = 1.0;
+  double pp[3] = {p.X(), p.Y(), p.Z()};
+  double dd[3] = {dr.X(), dr.Y(), dr.Z()};
+  double lo[3] = {lo_.X(), lo_.Y(), lo_.Z()};
+  double hi[3] = {hi_.X(), hi_.Y(), hi_.Z()};
+  long n[3] = {nx_, ny_, nz_};
+  for (int a=0; a < 3; ++a) {
+    if (dd[a] == 0.0) {
+      if (pp[a] < lo[a] or pp[a] > hi[a]) return 2.0;
+      continue;
+    }
+    double ta = (lo[a]-pp[a])/dd[a], tb = (hi[a]-pp[a])/dd[a];
+    if (ta > tb) swap(ta, tb);
+    t0 = max(t0, ta); t1 = min(t1, tb);
+  }
+  if (t0 > t1) return 2.0;
+
+  // 3D DDA (Amanatides-Woo) from the entry point
+  long idx[3], step[3];
+  double tMax[3], tDelta[3];
+  for (int a=0; a < 3; ++a) {
+    double s = (pp[a] + dd[a]*t0 - lo[a])/h_;
+    idx[a] = clampCell(s, n[a]);
+    if (dd[a] > 0.0) {
+      step[a] = 1;
+      tMax[a] = (lo[a] + (idx[a]+1)*h_ - pp[a])/dd[a];
+      tDelta[a] = h_/dd[a];
+    } else if (dd[a] < 0.0) {
+      step[a] = -1;
+      tMax[a] = (lo[a] + idx[a]*h_ - pp[a])/dd[a];
+      tDelta[a] = -h_/dd[a];
+    } else {
+      step[a] = 0;
+      tMax[a] = tDelta[a] = 2.0;
+    }
+  }
+
+  double min_t = 2.0;
+  while (true) {
+    // a later cell may only replace oid with a nearer hit
+    size_t cid;
+    double t = checkCell(cellIndex(idx[0], idx[1], idx[2]), p, dr, rw, cid);
+    if (t < min_t) { min_t = t; oid = cid; }
+
+    // leave current cell
+    int a = (tMax[0] < tMax[1]) ? ((tMax[0] < tMax[2]) ? 0 : 2) : ((tMax[1] < tMax[2]) ? 1 : 2);
+    // nearest hit is inside visited cells
+    if (min_t <= tMax[a] or tMax[a] > t1) break;
+    idx[a] += step[a];
+    if (idx[a] < 0 or idx[a] >= n[a]) break;
+    tMax[a] += tDelta[a];
+  }
+
+  return min_t;
+}
+
+size_t Obstacles::calNewStep(Vec3<double> p, Vec3<double> dr, double rw, vector<Vec3<double>>& legs) {
+  // split dr into straight legs reflected on obstacle surfaces
+  // output: number of obstacle hits, legs (sum of legs is the new step)
+  legs.clear();
+  size_t hit = 0;
+  size_t oid = 0;
+
+  while (true) {
+    double tt = getTimeForObstacle(p, dr, rw, oid);
+    if (tt > 1.0) { legs.push_back(dr); break; }
+
+    // move to contact point
+    legs.push_back(dr*tt);
+    p += dr*tt;
+    hit++;
+
+    // stop on the surface after too many reflections
+    if (hit >= maxReflection_) break;
+
+    // reflect remaining step on the surface normal
+    Obstacle& o = olist_[oid];
+    Vec3<double> n{p.X()-o.x, p.Y()-o.y, p.Z()-o.z};
+    n.normalise();
+    Vec3<double> rest = dr*(1.0-tt);
+    dr = rest - n*(2.0*rest.dotProduct(n));
+  }
+
+  hitCount_ += hit;
+  return hit;
+}
+
+#endif
+
+// vim:foldmethod=syntax:foldlevel=0
@@ -5,6 +5,7 @@
 // date: 20160616 version: 1.0.1 update: add comments
 // date: 20160617 version: 1.0.2 update: separate read file pattern
 // date: 2017-09-18 version: 2.0.0 update: add more types
+// date: 20261018 - set values, copies without saving (population cells)
 
 #ifndef PARAMETERREADER_H
 #define PARAMETERREADER_H
@@ -23,6 +24,7 @@ class ParameterReader {
     string simfilename_;
     string printbuffer_;
     vector<string> lines_;
+    bool saveOnExit_ = true;
 
   public:
   ParameterReader(string filename) {
@@ -38,7 +40,7 @@ class ParameterReader {
     ParameterReader("test.par");
   }
   virtual ~ParameterReader() {
-    save(simfilename_);
+    if (saveOnExit_) save(simfilename_);
   };
 
   void readfromtxt(string fn);
@@ -59,8 +61,11 @@ class ParameterReader {
   vector<string> arrayRead(string name, string defvalue, bool verbose=true, string selector=":");
 
   bool checkName(string name, string selector=":");
+  void set(string name, string value, string selector=":");
 
   inline string simfilename() { return simfilename_; }
+  inline void simfilename(string fn) { simfilename_ = fn; }
+  inline void saveOnExit(bool s) { saveOnExit_ = s; }
 };
 
 #endif
@@ -0,0 +1,119 @@
+// Philox.hpp
+// counter-based random number generator (Philox4x32-10) as gsl_rng type
+//
+// author: sungcheolkim @ IBM
+// date: 20261018 - initial version (keyed streams, batch uniform)
+// date: 20261018 - lanes of a walker stream
+//
+// output block = philox(counter, key). the key holds (seed, cloud) and the
+// counter holds (walker, step, block, lane), so every walker in every step has
+// its own stream that does not depend on the order walkers are moved in, and
+// any step can be replayed by setting the counter (jump-ahead). lanes > 0 are
+// further streams of the same walker and step for draws made on its behalf. the type plugs
+// into gsl_rng_alloc, so all gsl_ran_* distributions work on it.
+
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <stdint.h>
+#include <gsl/gsl_rng.h>
+
+struct philox_state_t {
+  uint32_t ctr[4];
+  uint32_t key[2];
+  uint32_t out[4];
+  unsigned int idx;             // next word in out (4: new block needed)
+};
+
+inline void philox4x32_10(const uint32_t* ctr, const uint32_t* key, uint32_t* out) {
+  uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+  uint32_t k0 = key[0], k1 = key[1];
+
+  for (int r=0; r < 10; ++r) {
+    uint64_t p0 = (uint64_t)0xD2511F53u*c0;
+    uint64_t p1 = (uint64_t)0xCD9E8D57u*c2;
+    uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+    uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+    c0 = n0; c1 = (uint32_t)p1; c2 = n2; c3 = (uint32_t)p0;
+    k0 += 0x9E3779B9u; k1 += 0xBB67AE85u;
+  }
+  out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+}
+
+static inline unsigned long int philox_get(void* vstate) {
+  philox_state_t* s = (philox_state_t*)vstate;
+  if (s->idx == 4) {
+    philox4x32_10(s->ctr, s->key, s->out);
+    if (++s->ctr[2] == 0) ++s->ctr[3];
+    s->idx = 0;
+  }
+  return s->out[s->idx++];
+}
+
+static inline double philox_get_double(void* vstate) {
+  return philox_get(vstate)/4294967296.0;
+}
+
+static void philox_set(void* vstate, unsigned long int seed) {
+  philox_state_t* s = (philox_state_t*)vstate;
+  s->key[0] = (uint32_t)seed;
+  s->key[1] = (uint32_t)((uint64_t)seed >> 32);
+  s->ctr[0] = s->ctr[1] = s->ctr[2] = s->ctr[3] = 0;
+  s->idx = 4;
+}
+
+static const gsl_rng_type philox_type = {
+  "philox4x32", 0xffffffffUL, 0, sizeof(philox_state_t),
+  &philox_set, &philox_get, &philox_get_double
+};
+const gsl_rng_type* gsl_rng_philox = &philox_type;
+
+// key (seed, cloud) - seed is folded to 32 bits
+inline void philox_key(gsl_rng* r, unsigned long int seed, uint32_t cloud) {
+  philox_state_t* s = (philox_state_t*)r->state;
+  s->key[0] = (uint32_t)seed ^ (uint32_t)((uint64_t)seed >> 32);
+  s->key[1] = cloud;
+  s->ctr[0] = s->ctr[1] = s->ctr[2] = s->ctr[3] = 0;
+  s->idx = 4;
+}
+
+// select stream (walker, step, lane) - block counter starts at 0
+inline void philox_stream(gsl_rng* r, uint32_t walker, uint32_t step, uint32_t lane = 0) {
+  philox_state_t* s = (philox_state_t*)r->state;
+  s->ctr[0] = walker;
+  s->ctr[1] = step;
+  s->ctr[2] = 0;
+  s->ctr[3] = lane;
+  s->idx = 4;
+}
+
+// n uniform numbers in [0, 1) - whole blocks at once for philox generators
+inline void rngUniform(gsl_rng* r, double* u, size_t n) {
+  if (r->type != gsl_rng_philox) {
+    for (size_t i=0; i < n; ++i) u[i] = gsl_rng_uniform(r);
+    return;
+  }
+
+  philox_state_t* s = (philox_state_t*)r->state;
+  size_t i = 0;
+  // use the rest of the current block first
+  while ((s->idx < 4) and (i < n)) u[i++] = s->out[s->idx++]/4294967296.0;
+
+  // independent blocks - no dependency between iterations
+  size_t nb = (n - i)/4;
+  uint32_t ctr[4] = {s->ctr[0], s->ctr[1], s->ctr[2], s->ctr[3]};
+  for (size_t b=0; b < nb; ++b) {
+    uint32_t c[4] = {ctr[0], ctr[1], (uint32_t)(ctr[2] + b), ctr[3]};
+    uint32_t out[4];
+    philox4x32_10(c, s->key, out);
+    for (int k=0; k < 4; ++k) u[i + 4*b + k] = out[k]/4294967296.0;
+  }
+  s->ctr[2] += (uint32_t)nb;
+  i += 4*nb;
+
+  while (i < n) u[i++] = gsl_rng_uniform(r);
+}
+
+#endif
+
+// vim:foldmethod=syntax:foldlevel=0
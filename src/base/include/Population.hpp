@@ -0,0 +1,151 @@
+// Population.hpp
+// many cells in one run, one simulator per cell
+//
+// author: sungcheolkim @ IBM
+// date: 20261018 - initial version
+// date: 20261019 - cell file names as strings
+// date: 20261019 - runs on MultiRun
+//
+// population Cells: M builds M simulators from copies of the parameter file.
+// every key of "population Vary" is drawn per cell from "population <key>":
+// Normal(m, s) (redrawn until positive), Uniform(a, b), LogNormal(mu, sigma)
+// or a fixed number, and set for every cloud ("<cloud> <key>"), so all clouds
+// of a cell share its geometry. each cell has its own frame, seed (seed + k),
+// generator keys, walker pools and location grids; cells never interact. they
+// step together as the runs of MultiRun (population Threads, 0: all cores).
+// products of every cell go to one file per info cycle and the population
+// mean, spread and range to the screen.
+
+#ifndef POPULATION_H
+#define POPULATION_H
+
+#include <iomanip>
+#include <numeric>
+#include "MultiRun.hpp"
+
+using namespace std;
+
+class Population: public MultiRun {
+
+public:
+  // member functions
+  void injectCells(ParameterReader& pr);
+  void report(bool last);
+  double draw(string spec);
+
+  // constructor
+  Population(ParameterReader& pr, Log* lg): MultiRun{pr, lg, "population", "cells"} {
+    cout << blu << "[Population] is initialized." << def << endl;
+    cellNumber_ = pr.intRead("population Cells", "1");
+    vary_ = pr.arrayRead("population Vary", "(Cell Length)");
+    for (auto key : vary_) spec_.push_back(pr.stringRead("population " + key, "Normal(6, 0.5)"));
+
+    // draws of the cell parameters, apart from the walker streams
+    rs_ = gsl_rng_alloc(gsl_rng_mt19937);
+    gsl_rng_set(rs_, seed_);
+  }
+  virtual ~Population() { gsl_rng_free(rs_); }
+
+  // inline functions
+  inline size_t cellNumber() { return cellNumber_; }
+
+private:
+  size_t cellNumber_;
+  gsl_rng* rs_;
+
+  vector<string> vary_;             // keys drawn per cell
+  vector<string> spec_;             // their distributions
+  vector<vector<double>> values_;   // drawn values per cell
+};
+
+double Population::draw(string spec) {
+  auto o = spec.find("(");
+  if (o == string::npos) return stod(spec);
+  auto c = spec.find(",", o);
+  auto e = spec.find(")", o);
+  if ((c == string::npos) or (e == string::npos)) {
+    cerr << "... population: [Normal|Uniform|LogNormal](a, b) or number " << spec << endl;
+    exit(1);
+  }
+  double a = stod(spec.substr(o+1, c-o-1));
+  double b = stod(spec.substr(c+1, e-c-1));
+  string kind = spec.substr(0, o);
+  if (kind.find("LogNormal") != string::npos) return gsl_ran_lognormal(rs_, a, b);
+  if (kind.find("Uniform") != string::npos) return gsl_ran_flat(rs_, a, b);
+  if (kind.find("Normal") != string::npos) {
+    double v;
+    do { v = a + gsl_ran_gaussian(rs_, b); } while (v <= 0.0);
+    return v;
+  }
+  cerr << "... population: unknown distribution " << spec << endl;
+  exit(1);
+}
+
+void Population::injectCells(ParameterReader& pr) {
+  vector<string> names = pr.arrayRead("species Name", "(Enzyme, Substrate)", false);
+
+  for (size_t k=0; k < cellNumber_; ++k) {
+    // <name>_c0000.par
+    ParameterReader* p = copyParameters(pr, "_c" + numbered(k, 4), seed_ + k);
+    values_.push_back({});
+    for (size_t i=0; i < vary_.size(); ++i) {
+      double v = draw(spec_[i]);
+      values_[k].push_back(v);
+      for (auto n : names) p->set(n + " " + vary_[i], to_string(v));
+    }
+    addRun(p);
+  }
+  startRuns();
+
+  cout << "... population: " << cellNumber_ << " cells on " << pool_->threads() << " thread(s), vary";
+  for (size_t i=0; i < vary_.size(); ++i) cout << " " << vary_[i] << ": " << spec_[i];
+  cout << endl;
+
+  // column names
+  ofstream f(saveName_.c_str(), ios::out|ios::trunc);
+  f << "# time cell";
+  for (auto key : vary_) f << " [" << key << "]";
+  for (size_t i=0; i < productClouds_.size(); ++i) f << " [" << productID(i) << " Product]";
+  f << endl;
+}
+
+void Population::report(bool last) {
+  // one line per cell in the file, population statistics on screen
+  ofstream f(saveName_.c_str(), ios::out|ios::app);
+  for (size_t k=0; k < cellNumber_; ++k) {
+    f << runs_[k]->time() << " " << k;
+    for (auto v : values_[k]) f << " " << v;
+    for (size_t i=0; i < productClouds_.size(); ++i) f << " " << product(k, i)->hitSubstrate();
+    f << endl;
+  }
+
+  for (size_t i=0; i < productClouds_.size(); ++i) {
+    vector<double> x, rate;
+    for (size_t k=0; k < cellNumber_; ++k) {
+      x.push_back(product(k, i)->hitSubstrate());
+      BatchMeans* bm = product(k, i)->rateStatistics();
+      if ((bm != nullptr) and (bm->batches() > 1)) rate.push_back(bm->mean());
+    }
+    double m = accumulate(x.begin(), x.end(), 0.0)/x.size();
+    double v = 0.0;
+    for (auto a : x) v += (a - m)*(a - m);
+    double sd = (x.size() > 1) ? sqrt(v/(x.size() - 1)) : 0.0;
+    string id = productID(i);
+    cout << id << " Product: " << red << m << def << " +- " << sd << " ("
+         << *min_element(x.begin(), x.end()) << " - " << *max_element(x.begin(), x.end()) << ") over " << x.size() << " cells" << endl;
+
+    if (last and !rate.empty()) {
+      double rm = accumulate(rate.begin(), rate.end(), 0.0)/rate.size();
+      double rv = 0.0;
+      for (auto a : rate) rv += (a - rm)*(a - rm);
+      double rsd = (rate.size() > 1) ? sqrt(rv/(rate.size() - 1)) : 0.0;
+      cout << id << " Steady Rate: " << red << rm << def << " +- " << rsd << " [uM/s] over " << rate.size() << " cells" << endl;
+      log_->write(to_string(runs_[0]->time()) + " " + id + " population " + to_string(cellNumber_) + " product "
+                  + to_string(m) + " " + to_string(sd) + " steady rate " + to_string(rm) + " " + to_string(rsd));
+    }
+  }
+}
+
+#endif
+
+// vim:foldmethod=syntax:foldlevel=0
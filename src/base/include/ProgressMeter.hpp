@@ -0,0 +1,98 @@
+// ProgressMeter.hpp
+// throughput, memory and ETA of a running simulation
+//
+// author: sungcheolkim @ IBM
+// date: 20261018 - initial version (window rates, record line)
+//
+// sample() keeps the counters of the last window_ info cycles; rates are the
+// differences between the oldest and newest sample, so a slow phase shows up
+// after a few cycles and old history does not hide a stall. record() is one
+// line of key=value pairs for batch schedulers.
+
+#ifndef PROGRESSMETER_H
+#define PROGRESSMETER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <deque>
+#include <string>
+#include <sstream>
+#include <algorithm>
+
+using namespace std;
+
+struct ProgressSample {
+  double sec;                   // wall time since start
+  uint64_t itr;
+  uint64_t steps;               // walker steps
+  uint64_t checks;              // distance tests (substrates, reactions, interactions)
+  uint64_t bytes;               // trajectory and map output
+};
+
+class ProgressMeter {
+
+public:
+  // member functions
+  void sample(ProgressSample s);
+  double rate(uint64_t ProgressSample::*counter);
+  double eta();
+  string record();
+  static size_t residentBytes();
+
+  // constructor
+  ProgressMeter(size_t total, size_t window=10): total_(total), window_(window) { }
+  virtual ~ProgressMeter() { };
+
+  // inline functions
+  inline double itrRate() { return rate(&ProgressSample::itr); }
+  inline double stepRate() { return rate(&ProgressSample::steps); }
+  inline double checkRate() { return rate(&ProgressSample::checks); }
+  inline double byteRate() { return rate(&ProgressSample::bytes); }
+  inline ProgressSample& last() { return samples_.back(); }
+
+private:
+  size_t total_;
+  size_t window_;
+  deque<ProgressSample> samples_;
+};
+
+void ProgressMeter::sample(ProgressSample s) {
+  samples_.push_back(s);
+  if (samples_.size() > window_ + 1) samples_.pop_front();
+}
+
+double ProgressMeter::rate(uint64_t ProgressSample::*counter) {
+  if (samples_.size() < 2) return 0.0;
+  double dt = samples_.back().sec - samples_.front().sec;
+  return (dt > 0.0) ? (double)(samples_.back().*counter - samples_.front().*counter)/dt : 0.0;
+}
+
+double ProgressMeter::eta() {
+  double r = itrRate();
+  if ((r <= 0.0) or samples_.empty()) return -1.0;
+  return (double)(total_ - min((uint64_t)total_, samples_.back().itr))/r;
+}
+
+string ProgressMeter::record() {
+  ProgressSample& s = samples_.back();
+  ostringstream os;
+  os << "PROGRESS itr=" << s.itr << " total=" << total_ << " elapsed=" << s.sec
+     << " itr_per_s=" << itrRate() << " steps_per_s=" << stepRate() << " checks_per_s=" << checkRate()
+     << " bytes_per_s=" << byteRate() << " rss=" << residentBytes() << " eta=" << eta();
+  return os.str();
+}
+
+size_t ProgressMeter::residentBytes() {
+  // linux: resident pages in second field
+  size_t pages = 0, rss = 0;
+  FILE* f = fopen("/proc/self/statm", "r");
+  if (f == nullptr) return 0;
+  if (fscanf(f, "%zu %zu", &pages, &rss) != 2) rss = 0;
+  fclose(f);
+  return rss*(size_t)sysconf(_SC_PAGESIZE);
+}
+
+#endif
+
+// vim:foldmethod=syntax:foldlevel=0
@@ -0,0 +1,343 @@
+// Reactions.hpp
+// reaction table between clouds (A + B -> C, A + B -> A + C, A -> B, A + B <-> C)
+//
+// author: sungcheolkim @ IBM
+// date: 20261018 - initial version (per rule cell list)
+// date: 20261019 - cell list follows the size of cloud b
+//
+// each rule is read from "<name> Equation". a reactant that also appears in
+// the products is kept (catalyst), others are removed and the remaining
+// products are created as new walkers at the reaction site. second order
+// rules fire when a B walker is within "Reaction Distance" of the segment
+// that A walked during the step, with "Probability". first order rules fire
+// with 1 - exp(-Rate*dt). "<->" adds the first order unbinding rule C -> A + B
+// with "Unbinding Rate". a walker takes part in one reaction per step.
+
+#ifndef REACTIONS_H
+#define REACTIONS_H
+
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <math.h>
+#include <gsl/gsl_rng.h>
+#include "Vec3.hpp"
+#include "Log.hpp"
+#include "ParameterReader.h"
+#include "Cloud.hpp"
+#include "CellList.hpp"
+#include "Philox.hpp"
+
+using namespace std;
+
+struct ReactionRule {
+  string name;
+  size_t a;                         // reactant cloud index
+  size_t b;                         // second reactant (npos for first order)
+  bool keepA;
+  bool keepB;
+  vector<size_t> created;           // product cloud indices to create
+  double distance;                  // [um]
+  double probability;
+  double rate;                      // [1/s]
+  CellList cl;                      // cell list of cloud b
+  size_t sized;                     // size of cloud b the cells are set for
+  size_t built;                     // version of static cloud b in cl
+  size_t count;
+};
+
+class Reactions {
+
+public:
+  // member functions
+  void prepare();
+  void apply(double dt);
+  void info(double time);
+
+  // constructor
+  Reactions(ParameterReader& pr, vector<Cloud*>& clouds):
+    clouds_(clouds)
+  {
+    cout << blu << "[Reactions] is initialized." << def << endl;
+
+    for (auto name : pr.arrayRead("reaction Names", "(R1)")) {
+      string eq = pr.stringRead(name+" Equation", "Enzyme + Substrate -> Enzyme + Product");
+      bool reversible = (eq.find("<->") != string::npos);
+      auto found = eq.find(reversible ? "<->" : "->");
+      if (found == string::npos) {
+        cerr << "... reaction equation format: A + B -> C " << eq << endl;
+        exit(1);
+      }
+      vector<size_t> lhs = parseSide(eq.substr(0, found));
+      vector<size_t> rhs = parseSide(eq.substr(found + (reversible ? 3 : 2)));
+      if ((lhs.size() == 0) or (lhs.size() > 2)) {
+        cerr << "... reaction needs one or two reactants: " << eq << endl;
+        exit(1);
+      }
+
+      double distance = 0.0, probability = 1.0, rate = 0.0;
+      if (lhs.size() == 2) {
+        distance = pr.doubleRead(name+" Reaction Distance", "5")/1000.0;     // [nm] -> [um]
+        probability = pr.doubleRead(name+" Probability", "1.0");
+      } else
+        rate = pr.doubleRead(name+" Rate", "1.0");
+      addRule(name, lhs, rhs, distance, probability, rate);
+
+      if (reversible and (rhs.size() != 1)) {
+        cerr << "... reversible reaction needs one product: " << eq << endl;
+        exit(1);
+      }
+      if (reversible)
+        addRule(name+"r", rhs, lhs, 0.0, 1.0, pr.doubleRead(name+" Unbinding Rate", "1.0"));
+    }
+
+    // species count file
+    string tmp = pr.simfilename();
+    if (tmp.find(".par") != string::npos)
+      saveCountName_ = tmp.substr(0, tmp.find(".par")) + "_reaction_count.txt";
+    else if (tmp.find(".txt") != string::npos)
+      saveCountName_ = tmp.substr(0, tmp.find(".txt")) + "_reaction_count.txt";
+    else
+      saveCountName_ = tmp + "_reaction_count.txt";
+    fstream f;
+    f.open(saveCountName_, ios::out);
+    f << "# time";
+    for (auto c : clouds_) f << " " << c->cloudID();
+    for (auto& rr : rlist_) f << " " << rr.name;
+    f << endl;
+    f.close();
+
+    start_.resize(clouds_.size());
+    used_.resize(clouds_.size());
+  }
+  virtual ~Reactions() { };
+
+  inline uint64_t checks() { return checks_; }
+
+private:
+  vector<size_t> parseSide(string s);
+  void addRule(string name, vector<size_t>& lhs, vector<size_t>& rhs, double distance, double probability, double rate);
+  void fire(ReactionRule& rr, size_t i, size_t j);
+  void update();
+
+  vector<Cloud*>& clouds_;
+  vector<ReactionRule> rlist_;
+  string saveCountName_;
+
+  // per cloud state during one step
+  vector<vector<Vec3<double>>> start_;   // positions before moving
+  vector<vector<char>> used_;            // reacted in this step
+  vector<pair<size_t, size_t>> removal_;  // (cloud, index)
+  vector<pair<size_t, Walker*>> site_;    // (product cloud, reactant at site)
+  vector<size_t> cells_;                 // reusable buffer for cells
+  vector<double> u_;                     // reusable buffer for uniforms
+  uint64_t checks_ = 0;                  // segment distance tests
+};
+
+vector<size_t> Reactions::parseSide(string s) {
+  vector<size_t> side;
+  stringstream ss(s);
+  string item;
+
+  while (getline(ss, item, '+')) {
+    item.erase(0, item.find_first_not_of(" \t"));
+    item.erase(item.find_last_not_of(" \t\n\r")+1);
+    if (item.empty() or (item == "0")) continue;       // "A -> 0" degradation
+
+    size_t idx = clouds_.size();
+    for (size_t k=0; k < clouds_.size(); ++k)
+      if (clouds_[k]->cloudID() == item) idx = k;
+    if (idx == clouds_.size()) {
+      cerr << "... no cloud for reaction species " << item << endl;
+      exit(1);
+    }
+    side.push_back(idx);
+  }
+  return side;
+}
+
+void Reactions::addRule(string name, vector<size_t>& lhs, vector<size_t>& rhs, double distance, double probability, double rate) {
+  ReactionRule rr;
+  rr.name = name;
+  rr.a = lhs[0];
+  rr.b = (lhs.size() == 2) ? lhs[1] : string::npos;
+  rr.distance = distance;
+  rr.probability = probability;
+  rr.rate = rate;
+  rr.built = (size_t)-1;
+  rr.sized = 0;
+  rr.count = 0;
+
+  // reactants appearing in products are kept
+  rr.created = rhs;
+  auto keep = [&rr](size_t c) {
+    auto it = find(rr.created.begin(), rr.created.end(), c);
+    if (it == rr.created.end()) return false;
+    rr.created.erase(it);
+    return true;
+  };
+  rr.keepA = keep(rr.a);
+  rr.keepB = (rr.b != string::npos) ? keep(rr.b) : true;
+
+  cout << "... add reaction " << name << ": " << clouds_[rr.a]->cloudID();
+  if (rr.b != string::npos) cout << " + " << clouds_[rr.b]->cloudID();
+  cout << " ->";
+  for (auto c : rhs) cout << " " << clouds_[c]->cloudID();
+  if (rr.b != string::npos) {
+    // cell at least as large as reaction distance
+    Cloud* cb = clouds_[rr.b];
+    rr.sized = max((size_t)cb->size(), (size_t)1);
+    rr.cl.setGrid(cb->sf()->minDimension(), cb->sf()->maxDimension(), rr.distance, rr.sized);
+    cout << " distance: " << gre << rr.distance*1000.0 << def << " [nm] probability: " << gre << rr.probability << def << endl;
+  } else
+    cout << " rate: " << gre << rr.rate << def << " [1/s]" << endl;
+
+  rlist_.push_back(rr);
+}
+
+void Reactions::prepare() {
+  // record positions before moving for swept search
+  for (size_t k=0; k < clouds_.size(); ++k) {
+    start_[k].resize(clouds_[k]->size());
+    for (size_t i=0; i < clouds_[k]->size(); ++i)
+      start_[k][i] = (*clouds_[k])[i]->position();
+    used_[k].assign(clouds_[k]->size(), 0);
+  }
+}
+
+void Reactions::fire(ReactionRule& rr, size_t i, size_t j) {
+  Walker* wa = (*clouds_[rr.a])[i];
+  used_[rr.a][i] = 1;
+  if (clouds_[rr.a]->densityMap() != nullptr) clouds_[rr.a]->densityMap()->add(mapReaction, wa->position());
+  if (!rr.keepA) removal_.push_back(make_pair(rr.a, i));
+  if (rr.b != string::npos) {
+    used_[rr.b][j] = 1;
+    if (!rr.keepB) removal_.push_back(make_pair(rr.b, j));
+  }
+  for (auto c : rr.created) site_.push_back(make_pair(c, wa));
+  rr.count++;
+}
+
+void Reactions::update() {
+  // create products before removal - site walkers are still alive
+  vector<Walker*> product;
+  for (auto& s : site_) {
+    Cloud* c = clouds_[s.first];
+    Vec3<double> p = s.second->position();
+    // site outside of product surface: random position
+    if (!c->sf()->isInside(p)) p = c->calRandomPosition();
+    Walker* w = c->newWalker(p);
+    product.push_back(w);
+  }
+
+  // remove from back so that swapped walkers keep their indices valid
+  sort(removal_.begin(), removal_.end(), [](const pair<size_t, size_t>& x, const pair<size_t, size_t>& y) {
+    return (x.first != y.first) ? (x.first < y.first) : (x.second > y.second); });
+  removal_.erase(unique(removal_.begin(), removal_.end()), removal_.end());
+  for (auto& r : removal_) {
+    clouds_[r.first]->removeWalker(r.second);
+    // follow swap in removeWalker
+    start_[r.first][r.second] = start_[r.first].back();
+    start_[r.first].pop_back();
+    used_[r.first][r.second] = used_[r.first].back();
+    used_[r.first].pop_back();
+  }
+
+  // new walkers do not react in this step
+  for (size_t k=0; k < site_.size(); ++k) {
+    Cloud* c = clouds_[site_[k].first];
+    product[k]->tid(c->size());
+    c->addWalker(product[k]);
+    start_[site_[k].first].push_back(product[k]->position());
+    used_[site_[k].first].push_back(1);
+  }
+
+  removal_.clear();
+  site_.clear();
+}
+
+void Reactions::apply(double dt) {
+  for (size_t r=0; r < rlist_.size(); ++r) {
+    ReactionRule& rr = rlist_[r];
+    Cloud* ca = clouds_[rr.a];
+    // keyed generator: stream of rule in this step (after walker streams)
+    if (ca->rs()->type == gsl_rng_philox)
+      philox_stream(ca->rs(), 0xffffffffu - (uint32_t)r, (uint32_t)ca->step());
+
+    // first order
+    if (rr.b == string::npos) {
+      double p = 1.0 - exp(-rr.rate*dt);
+      u_.resize(ca->size());
+      rngUniform(ca->rs(), u_.data(), u_.size());
+      for (size_t i=0; i < ca->size(); ++i)
+        if (!used_[rr.a][i] and (u_[i] < p))
+          fire(rr, i, 0);
+      update();
+      continue;
+    }
+
+    // second order - B walkers near the segment A walked
+    Cloud* cb = clouds_[rr.b];
+    if ((ca->size() == 0) or (cb->size() == 0)) continue;
+    // cells follow B by factors of two - a product cloud starts empty
+    if ((cb->size() > 2*rr.sized) or (2*cb->size() < rr.sized)) {
+      rr.sized = cb->size();
+      rr.cl.setGrid(cb->sf()->minDimension(), cb->sf()->maxDimension(), rr.distance, rr.sized);
+      rr.built = (size_t)-1;
+    }
+    // static B keeps its cell list until relocation or removal
+    if (!cb->isStatic() or (rr.built != cb->updateCount() + cb->moveCount())) {
+      rr.cl.build(cb->wlist());
+      rr.built = cb->updateCount() + cb->moveCount();
+    }
+    double d2 = rr.distance*rr.distance;
+
+    for (size_t i=0; i < ca->size(); ++i) {
+      if (used_[rr.a][i]) continue;
+      Vec3<double> p0 = start_[rr.a][i];
+      Vec3<double> dr = (*ca)[i]->position() - p0;
+      Vec3<double> lo{min(p0.X(), p0.X()+dr.X()) - rr.distance, min(p0.Y(), p0.Y()+dr.Y()) - rr.distance,
+                      min(p0.Z(), p0.Z()+dr.Z()) - rr.distance};
+      Vec3<double> hi{max(p0.X(), p0.X()+dr.X()) + rr.distance, max(p0.Y(), p0.Y()+dr.Y()) + rr.distance,
+                      max(p0.Z(), p0.Z()+dr.Z()) + rr.distance};
+      rr.cl.boxCells(lo, hi, cells_);
+
+      // closest partner to the segment
+      size_t partner = string::npos;
+      double best = d2;
+      for (auto c : cells_)
+        for (uint32_t k=rr.cl.start(c); k < rr.cl.end(c); ++k) {
+          uint32_t j = rr.cl.item(k);
+          if (((rr.a == rr.b) and (j == i)) or used_[rr.b][j]) continue;
+          checks_++;
+          Vec3<double> sp = (*cb)[j]->position();
+          double t = (dr.mag2() > 0.0) ? Vec3<double>::dotProduct(sp - p0, dr)/dr.mag2() : 0.0;
+          t = min(max(t, 0.0), 1.0);
+          double dist2 = (p0 + dr*t - sp).mag2();
+          if (dist2 <= best) { best = dist2; partner = j; }
+        }
+
+      if ((partner != string::npos) and (gsl_rng_uniform(ca->rs()) < rr.probability))
+        fire(rr, i, partner);
+    }
+    update();
+  }
+}
+
+void Reactions::info(double time) {
+  for (auto& rr : rlist_)
+    cout << "Reaction " << rr.name << " Count: " << rr.count << endl;
+
+  fstream f;
+  f.open(saveCountName_, ios::out|ios::app);
+  f << time;
+  for (auto c : clouds_) f << " " << c->size();
+  for (auto& rr : rlist_) f << " " << rr.count;
+  f << endl;
+  f.close();
+}
+
+#endif
+
+// vim:foldmethod=syntax:foldlevel=0
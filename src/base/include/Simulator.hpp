@@ -3,6 +3,14 @@
 //
 // author: Sung-Cheol Kim @ IBM
 // date: 2017/09/07 - derived from cell.h
+// date: 20261018 - stop when product rate converged
+// date: 20261018 - throughput, memory and ETA report
+// date: 20261018 - periodic reorder of walker records
+// date: 20261018 - double time, position precision in info
+// date: 20261018 - independent cloud groups on a task pool
+// date: 20261018 - walkers of a cloud on a work stealing pool
+// date: 20261018 - memory policy for walker blocks
+// date: 20261018 - weighted ensemble resampling
 //
 
 #ifndef SIMULATOR_H
@@ -11,6 +19,15 @@
 #include "Cloud.hpp"
 #include "CloudBase.hpp"
 #include "CloudCell.hpp"
+#include "CloudField.hpp"
+#include "Obstacles.hpp"
+#include "Interactions.hpp"
+#include "Reactions.hpp"
+#include "WeightedEnsemble.hpp"
+#include "Philox.hpp"
+#include "ProgressMeter.hpp"
+#include "TaskPool.hpp"
+#include "MemoryPolicy.hpp"
 #include "ParameterReader.h"
 #include "progress_bar.hpp"
 #include "Log.hpp"
@@ -30,15 +47,27 @@ class Simulator {
     void evolveClouds();
     void run();
     void info();
+    bool converged();
+    void summary(size_t itr);
+    void progress(ProgressMeter& pm, double sec, size_t itr);
+    void scheduleClouds();
 
     // constructor
     Simulator(ParameterReader& pr, Log* lg):
       log_(lg),
       internalTime_(0.0),
       internalItr_(1),
-      cloudCount_(0) 
+      cloudCount_(0),
+      walkerSteps_(0),
+      obs_(nullptr),
+      inter_(nullptr),
+      react_(nullptr),
+      we_(nullptr),
+      pool_(nullptr),
+      walkerPool_(nullptr)
     {
       cout << blu << "[Simulator] is initialized." << def << endl;
+      cout << "... position precision: " << ((sizeof(real_t) == sizeof(float)) ? "float" : "double") << endl;
       dt_ = pr.doubleRead("dt", "0.0001");
       iteration_ = pr.intRead("iteration", "1000");
       cloudNames_ = pr.arrayRead("species Name", "(Enzyme, Substrate)");
@@ -51,42 +80,104 @@ class Simulator {
       saveCount_ = pr.boolRead("save Count", "False");
 
       showProg_ = pr.boolRead("show Progress", "True");
+      // key=value progress line on stdout and/or in a file for job schedulers
+      progRecord_ = pr.boolRead("progress Record", "False", false);
+      progFile_ = pr.stringRead("progress File", "", false);
+      progWindow_ = pr.intRead("progress Window", "10", false);
       debug_ = pr.boolRead("debug", "False");
+      obstacleOn_ = pr.boolRead("obstacle On", "False");
+      interactionOn_ = pr.boolRead("interaction On", "False");
+      reactionOn_ = pr.boolRead("reaction On", "False");
+      // split and merge weighted enzymes for rare substrate hits
+      ensembleOn_ = pr.boolRead("ensemble On", "False", false);
+
+      // clouds without shared substrate or generator move concurrently (0: all cores)
+      cloudThreads_ = pr.intRead("cloud Threads", "1", false);
+      if (cloudThreads_ == 0) cloudThreads_ = max(1u, thread::hardware_concurrency());
+      // walkers of a cloud in two phases on a work stealing pool (0: serial update)
+      walkerThreads_ = pr.intRead("walker Threads", "0", false);
+      walkerGrain_ = pr.intRead("walker Grain", "16", false);
+
+      // stop before iteration when the relative error of the steady product rate is reached
+      convergeOn_ = pr.boolRead("converge On", "False", false);
+      if (convergeOn_) {
+        convergeError_ = pr.doubleRead("converge Error", "0.01");
+        convergeBatches_ = pr.intRead("converge Min Batches", "32");
+        convergeLag_ = pr.doubleRead("converge Max Lag1", "0.3");
+      }
 
       cout << "... prepare random variable" << endl;
-      struct timeval tv;
-      gettimeofday(&tv, 0);
-      unsigned long int random_seed = tv.tv_sec+tv.tv_usec;
+      // seed: 0 - from clock
+      seed_ = stoul(pr.stringRead("seed", "0"));
+      if (seed_ == 0) {
+        struct timeval tv;
+        gettimeofday(&tv, 0);
+        seed_ = tv.tv_sec+tv.tv_usec;
+      }
 
+      // GSL: one generator for all clouds, Philox: keyed stream per walker and step
       gsl_rng_env_setup();
-      T_ = gsl_rng_default;   // gsl_rng_mt19937
+      if (pr.stringRead("random Generator", "GSL").find("Philox") != string::npos)
+        T_ = gsl_rng_philox;
+      else
+        T_ = gsl_rng_default;   // gsl_rng_mt19937
       // T_ = gsl_rng_ranlxs0;
       rs_ = gsl_rng_alloc(T_);
-      gsl_rng_set(rs_, random_seed);
+      gsl_rng_set(rs_, seed_);
 
       cout << "... generator: " << gsl_rng_name(rs_) << endl;
-      cout << "... seed: " << random_seed << endl;
+      cout << "... seed: " << seed_ << endl;
+
+      // walker pool serves one cloud at a time, positions independent of threads
+      // only with keyed streams
+      if (walkerThreads_ > 0) {
+        if (T_ != gsl_rng_philox) {
+          cerr << "... walker Threads needs random Generator: Philox" << endl;
+          exit(1);
+        }
+        walkerPool_ = new TaskPool(walkerThreads_);
+        if (pr.boolRead("walker Pin Threads", "False", false)) walkerPool_->pin();
+      }
+
+      // walker blocks: huge pages (Off, Madvise, Hugetlb), shares first written by walker threads
+      string huge = pr.stringRead("memory Huge Pages", "Off", false);
+      if (huge.find("Hugetlb") != string::npos) memory_.huge(HugePages::Hugetlb);
+      else if (huge.find("Madvise") != string::npos) memory_.huge(HugePages::Madvise);
+      if (pr.boolRead("memory First Touch", "True", false)) memory_.toucher(walkerPool_);
+      cout << "... memory: " << memory_.str() << endl;
     }
 
     virtual ~Simulator() {
+      if (we_ != nullptr) delete we_;
+      if (react_ != nullptr) delete react_;
+      if (inter_ != nullptr) delete inter_;
+      if (obs_ != nullptr) delete obs_;
+      if (pool_ != nullptr) delete pool_;
+      if (walkerPool_ != nullptr) delete walkerPool_;
+      // clouds free their walker pools by blocks
+      for (auto c : cloudList_) delete c;
+      for (auto r : cloudRs_) gsl_rng_free(r);
       gsl_rng_free(rs_);
     }
 
     inline gsl_rng* rs() { return rs_; }
-    float dt() { return dt_; }
+    double dt() { return dt_; }
     void dt(double t) { dt_ = t; }
     size_t iteration() { return iteration_; }
     void iteration(size_t itr) { iteration_ = itr; }
+    double time() { return internalTime_; }
+    vector<Cloud*>& cloudList() { return cloudList_; }
 
   protected:
     vector<Cloud*> cloudList_;
     Log* log_;
 
-    float internalTime_;
+    double internalTime_;
     size_t internalItr_;
     size_t cloudCount_;
+    uint64_t walkerSteps_;
 
-    float dt_;
+    double dt_;
     size_t iteration_;
     size_t cloudNumber_;
     vector<string> cloudNames_;
@@ -96,11 +187,45 @@ class Simulator {
     bool saveStep_;
     bool saveCount_;
     bool showProg_;
+    bool progRecord_;
+    string progFile_;
+    size_t progWindow_;
     bool debug_;
+    bool obstacleOn_;
+    bool interactionOn_;
+    bool reactionOn_;
+    bool ensembleOn_;
+    bool convergeOn_;
+    double convergeError_;        // target relative standard error
+    size_t convergeBatches_;
+    double convergeLag_;          // batch means correlation limit
+    size_t cloudThreads_;
+    size_t walkerThreads_;
+    size_t walkerGrain_;
+
+    // static obstacles shared by all clouds
+    Obstacles* obs_;
+    // excluded volume between walkers
+    Interactions* inter_;
+    // reaction table between clouds
+    Reactions* react_;
+    // resampling of weighted enzymes
+    WeightedEnsemble* we_;
 
     // prepare random number seed ; once for all
     const gsl_rng_type* T_;
     gsl_rng* rs_;
+    unsigned long int seed_;
+    vector<gsl_rng*> cloudRs_;    // keyed generators (seed, cloud)
+
+    // clouds that touch the same walkers or generator, moved in list order
+    vector<pair<size_t, size_t>> substrateOf_;      // (cloud, its substrate cloud)
+    vector<vector<size_t>> cloudGroups_;
+    vector<uint64_t> groupSteps_;
+    vector<function<void()>> moveTasks_;
+    TaskPool* pool_;
+    TaskPool* walkerPool_;
+    MemoryPolicy memory_;
 
   private:
 };
@@ -110,6 +235,7 @@ void Simulator::run() {
 
   cout << "... cal Total Simulation Time : " << dt_*iteration_ << " [s]" << endl;
   ProgressBar *bar = new ProgressBar(iteration_);
+  ProgressMeter pm{iteration_, progWindow_};
   size_t infoItr;
   string msg = "";
   msg = "dt: " + to_string(dt_) + " iteration: " + to_string(iteration_) + " [Start]";
@@ -118,35 +244,133 @@ void Simulator::run() {
   for (infoItr=0; infoItr<iteration_; infoItr++) {
       evolveClouds();
       writeClouds();
+      if ((infoItr%infoCycle_) == 0)
+        for (auto c : cloudList_) c->writeMap();
 
-      if(showProg_ && (infoItr%infoCycle_) == 0) {
+      if ((infoItr%infoCycle_) == 0) {
           high_resolution_clock::time_point t2 = high_resolution_clock::now();
+          progress(pm, duration<double>(t2 - t1).count(), infoItr);
+      }
+
+      if(showProg_ && (infoItr%infoCycle_) == 0) {
           int sep = 60;
-          auto runningSec = duration_cast<seconds>(t2 - t1).count();
+          auto runningSec = (long)pm.last().sec;
           if (infoItr == 0) { sep = 62; } 
           cout << blu << "[#] = " << infoItr << " " << string(sep,'-') << " " << runningSec << " [sec] " << def << endl;
+          if (infoItr > 0)
+            cout << "Throughput: " << pm.stepRate() << " [steps/s] " << pm.checkRate() << " [checks/s] "
+                 << pm.byteRate()/1048576.0 << " [MB/s] Memory: " << ProgressMeter::residentBytes()/1048576.0
+                 << " [MB] ETA: " << (long)pm.eta() << " [sec]" << endl;
           info();
       }
 
       bar->Progressed(infoItr);
+
+      if (convergeOn_ and ((infoItr+1)%infoCycle_ == 0) and converged()) {
+        infoItr++;
+        break;
+      }
   }
 
   // print info for the last iteration nd running time
   high_resolution_clock::time_point t2 = high_resolution_clock::now();
   auto runningSec = duration_cast<seconds>(t2 - t1).count();
   auto runningMin = duration_cast<minutes>(t2 - t1).count();
-  cout << blu << "[#] = " << iteration_ << " " << string(35,'-') << " running time: " << runningMin << " [mins] " << runningSec - 60*runningMin << " [secs]" << def << endl;
+  cout << blu << "[#] = " << infoItr << " " << string(35,'-') << " running time: " << runningMin << " [mins] " << runningSec - 60*runningMin << " [secs]" << def << endl;
   info();
+  for (auto c : cloudList_) c->writeMap();
+  if (convergeOn_) summary(infoItr);
+  progress(pm, duration<double>(t2 - t1).count(), infoItr);
+  delete bar;
+}
+
+void Simulator::progress(ProgressMeter& pm, double sec, size_t itr) {
+  ProgressSample ps{sec, itr, walkerSteps_, 0, 0};
+  for (auto c : cloudList_) {
+    ps.checks += c->checkCount();
+    ps.bytes += c->bytesWritten();
+  }
+  if (inter_ != nullptr) ps.checks += inter_->checks();
+  if (react_ != nullptr) ps.checks += react_->checks();
+  pm.sample(ps);
+
+  if (!progRecord_ and progFile_.empty()) return;
+  string rec = pm.record();
+  if (progRecord_) cout << rec << endl;
+  if (!progFile_.empty()) {
+    // replace - readers see the last complete line
+    string tmp = progFile_ + ".tmp";
+    ofstream f(tmp.c_str(), ios::out|ios::trunc);
+    f << rec << endl;
+    f.close();
+    rename(tmp.c_str(), progFile_.c_str());
+  }
+}
+
+bool Simulator::converged() {
+  // all clouds with product rate
+  size_t n = 0;
+  for (auto c : cloudList_) {
+    BatchMeans* bm = c->rateStatistics();
+    if (bm == nullptr) continue;
+    if ((bm->batches() < convergeBatches_) or (bm->relError() > convergeError_) or (bm->lag1() > convergeLag_))
+      return false;
+    n++;
+  }
+  return n > 0;
+}
+
+void Simulator::summary(size_t itr) {
+  bool done = converged();
+  cout << blu << "[Summary] " << (done ? "converged" : "not converged") << " at iteration " << itr
+       << " of " << iteration_ << " (" << itr*dt_ << " [s])" << def << endl;
+
+  string msg = "# itr: " + to_string(itr);
+  for (auto c : cloudList_) {
+    BatchMeans* bm = c->rateStatistics();
+    if (bm == nullptr) continue;
+    cout << c->cloudID() << " Steady Rate: " << red << bm->mean() << def << " +- " << bm->stdError()
+         << " [uM/s] rel. error: " << bm->relError() << " (target " << convergeError_ << ") batches: "
+         << bm->batches() << " x " << bm->batchSize() << " lag1: " << bm->lag1() << endl;
+    msg += " " + c->cloudID() + ": " + to_string(bm->mean()) + " +- " + to_string(bm->stdError());
+  }
+  log_->timestamp(done ? "[Converged]" : "[Not Converged]");
+  log_->write(msg);
 }
 
 void Simulator::injectClouds(ParameterReader& pr) {
+  // place obstacles before walkers - inflate index by largest walker radius
+  if (obstacleOn_) {
+    double margin = 0.0;
+    for (auto cname : cloudNames_)
+      margin = max(margin, pr.doubleRead(cname+" Particle Radius", "1")/1000.0);
+    obs_ = new Obstacles{pr, "Obstacle", margin};
+    obs_->injectObstacles(pr, rs_);
+  }
+
   // inject clouds
   for (auto cname : cloudNames_) {
     cout << gre << "... add " << cname << def << endl;
-    CloudCell* c = new CloudCell{pr, cname};
-    c->rs(rs_);
+    // abundant substrate as mean field or walkers
+    CloudBase* c;
+    if (pr.stringRead(cname+" Representation", "Particle").find("Field") != string::npos)
+      c = new CloudField{pr, cname};
+    else
+      c = new CloudCell{pr, cname};
+    if (T_ == gsl_rng_philox) {
+      gsl_rng* r = gsl_rng_alloc(T_);
+      philox_key(r, seed_, cloudCount_);
+      cloudRs_.push_back(r);
+      c->rs(r);
+    } else
+      c->rs(rs_);
     c->dt(dt_);
+    c->obstacles(obs_);
+    c->memoryPolicy(&memory_);
     c->injectWalkers(pr);
+    MemoryPlacement mp;
+    c->pool().placement(mp);
+    cout << "... walker blocks: " << mp.str() << endl;
     cloudList_.push_back(c);
     cloudCount_++;
   }
@@ -155,22 +379,99 @@ void Simulator::injectClouds(ParameterReader& pr) {
     if (pr.boolRead(cloudNames_[i]+" Substrate On", "False")) {
       string substrateName = pr.stringRead(cloudNames_[i]+" Substrate Name", "Substrate");
       for (auto j=0; j<cloudNames_.size(); j++)
-        if (substrateName == cloudNames_[j])
+        if (substrateName == cloudNames_[j]) {
           cloudList_[i]->setSubstrateCloud(cloudList_[j]);
+          substrateOf_.push_back(make_pair(i, j));
+        }
     }
+  scheduleClouds();
+  // check reaction table
+  if (reactionOn_)
+    react_ = new Reactions{pr, cloudList_};
+  // check excluded volume
+  if (interactionOn_)
+    inter_ = new Interactions{pr, cloudList_};
+  // replicas of one enzyme overlap: no excluded volume
+  if (ensembleOn_) {
+    if (interactionOn_) {
+      cerr << "... ensemble On needs interaction On: False" << endl;
+      exit(1);
+    }
+    we_ = new WeightedEnsemble{pr, cloudList_, seed_};
+  }
   // write initial positions
   writeClouds();
 }
 
 void Simulator::evolveClouds() {
-  for(auto i=0; i<cloudCount_; i++) {
-    cloudList_[i]->moveWalker(dt_);
-  }
+  // walker indices change only between steps
+  for (auto c : cloudList_) c->reorderWalkers(internalItr_);
+  if (react_ != nullptr) react_->prepare();
+  pool_->run(moveTasks_);
+  for (auto& s : groupSteps_) { walkerSteps_ += s; s = 0; }
+  if (react_ != nullptr) react_->apply(dt_);
+  if (inter_ != nullptr) inter_->apply(dt_);
+  if (we_ != nullptr) we_->resample(internalItr_);
+  for(size_t i=0; i<cloudCount_; i++) cloudList_[i]->sampleMap();
 
   internalTime_ += dt_;
   internalItr_++;
 }
 
+void Simulator::scheduleClouds() {
+  // an enzyme cloud reads and removes or relocates walkers of its substrate
+  // cloud, and the GSL generator is one stream for all clouds: such clouds are
+  // joined into one group (union-find) and move in list order
+  vector<size_t> root(cloudCount_);
+  for (size_t i=0; i < cloudCount_; ++i) root[i] = i;
+  function<size_t(size_t)> find = [&](size_t i) { return (root[i] == i) ? i : (root[i] = find(root[i])); };
+  for (auto e : substrateOf_) root[find(e.first)] = find(e.second);
+  if (T_ != gsl_rng_philox)
+    for (size_t i=1; i < cloudCount_; ++i) root[find(i)] = find(0);
+
+  cloudGroups_.clear();
+  vector<long> groupOf(cloudCount_, -1);
+  for (size_t i=0; i < cloudCount_; ++i) {
+    size_t r = find(i);
+    if (groupOf[r] < 0) { groupOf[r] = cloudGroups_.size(); cloudGroups_.push_back({}); }
+    cloudGroups_[groupOf[r]].push_back(i);
+  }
+
+  // one pool for walkers of all clouds
+  if (walkerPool_ != nullptr) {
+    for (auto c : cloudList_) c->walkerPool(walkerPool_, walkerGrain_);
+    if (cloudThreads_ > 1) {
+      cout << "... cloud Threads: 1 with walker Threads" << endl;
+      cloudThreads_ = 1;
+    }
+  }
+
+  groupSteps_.assign(cloudGroups_.size(), 0);
+  moveTasks_.clear();
+  for (size_t g=0; g < cloudGroups_.size(); ++g)
+    moveTasks_.push_back([this, g] {
+      for (auto i : cloudGroups_[g]) {
+        cloudList_[i]->time(internalTime_ + dt_);
+        cloudList_[i]->step(internalItr_);
+        // static clouds keep positions and age from simulator time
+        if (cloudList_[i]->isStatic()) continue;
+        cloudList_[i]->moveWalker(dt_);
+        groupSteps_[g] += cloudList_[i]->size();
+      }
+    });
+  pool_ = new TaskPool(min(cloudThreads_, cloudGroups_.size()));
+
+  cout << "... cloud groups:";
+  for (auto& grp : cloudGroups_) {
+    cout << " (";
+    for (size_t k=0; k < grp.size(); ++k) cout << (k ? ", " : "") << cloudList_[grp[k]]->cloudID();
+    cout << ")";
+  }
+  cout << " on " << pool_->threads() << " thread(s)" << endl;
+  if (walkerPool_ != nullptr)
+    cout << "... walkers on " << walkerPool_->threads() << " thread(s), grain " << walkerGrain_ << endl;
+}
+
 void Simulator::writeClouds() {
   if (saveTrace_) {
     if (internalItr_%saveCycle_ == 0)
@@ -182,6 +483,19 @@ void Simulator::writeClouds() {
 void Simulator::info() {
   for (size_t i=0; i<cloudCount_; i++)
     cloudList_[i]->info(log_);
+  if (inter_ != nullptr) inter_->info();
+  if (react_ != nullptr) react_->info(internalTime_);
+  if (we_ != nullptr) we_->info();
+
+  // load balance of the walker pool since start
+  if (walkerPool_ != nullptr) {
+    cout << "Walker Threads: " << walkerPool_->threads() << " utilization " << 100.0*walkerPool_->utilization() << " %" << endl;
+    for (size_t t=0; t < walkerPool_->threads(); ++t) {
+      TaskSlotStats& st = walkerPool_->stats(t);
+      cout << "... thread " << t << ": items " << st.items << " chunks " << st.chunks
+           << " steals " << st.steals << " busy " << st.busy << " [s]" << endl;
+    }
+  }
 }
 #endif
 
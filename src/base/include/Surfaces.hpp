@@ -2,6 +2,8 @@
 //
 // author: Sung-Cheol Kim @ IBM
 // date: 2017/09/07 - derived from cellgeo.h
+// date: 20261018 - region test by surface type
+// date: 20261018 - debug flag off unless set
 //
 
 #ifndef SURFACES_H
@@ -26,13 +28,16 @@ class Surfaces {
 
 public:
   // virtual functions
-  virtual bool isInside(float x, float y, float z) = 0;
+  virtual bool isInside(double x, double y, double z) = 0;
   virtual Vec3<double> calRandomPosition(gsl_rng* rs) = 0;
   virtual Vec3<double> calRandomPosition(gsl_rng* rs, SurfaceTypeClass sc) = 0;
   virtual Vec3<double> calNormal(Vec3<double> position) = 0;
   virtual Vec3<double> maxDimension() = 0;
   virtual Vec3<double> minDimension() = 0;
   virtual double calSurfaceDistance(Vec3<double> position) = 0;
+  // inside the region of type sc (shapes without regions: whole volume)
+  virtual bool isInsideType(Vec3<double> p, SurfaceTypeClass) { return isInside(p); }
+  virtual ~Surfaces() {};
 
   // member functions
   double getTimeForSurface(Vec3<double> position, Vec3<double> dr);
@@ -68,7 +73,7 @@ protected:
   double typeVolume_;
   double surfaceArea_;
   double pr_;
-  bool debug_;
+  bool debug_ = false;
 
 private:
 
@@ -19,7 +19,7 @@ class SurfacesBox: public Surfaces {
 
 public:
   // member functions
-  bool isInside(float x, float y, float z);
+  bool isInside(double x, double y, double z);
   inline bool isInside(Vec3<double> v) { return isInside(v.X(), v.Y(), v.Z()); }
   Vec3<double> calRandomPosition(gsl_rng* rs, SurfaceTypeClass sc=SurfaceTypeClass::volume);
   inline Vec3<double> calRandomPosition(gsl_rng* rs) { return calRandomPosition(rs, SurfaceTypeClass::volume); }
@@ -63,7 +63,7 @@ private:
   double pr_;       // particle radius
 };
 
-bool SurfacesBox::isInside(float x, float y, float z) {
+bool SurfacesBox::isInside(double x, double y, double z) {
   Vec3<double> p(x, y, z);
   if ( x < -width_/2.0+pr_ or x > width_/2.0-pr_)
     return false;
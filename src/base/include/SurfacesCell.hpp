@@ -4,6 +4,7 @@
 // author: sungcheolkim @ IBM
 // date: 20160618 version: 1.0.0
 // date: 20160630 version: 1.1.0 update: 4 types of active site distribution
+// date: 20261018 - region test by type
 
 #ifndef CELLSURFACES_H
 #define CELLSURFACES_H
@@ -22,18 +23,19 @@ using namespace std;
 class SurfacesCell : public Surfaces {
 public:
   // member functions
-  bool isInside(float x, float y, float z);
+  bool isInside(double x, double y, double z);
   inline bool isInside(Vec3<double> v) { return isInside(v.X(), v.Y(), v.Z()); }
   Vec3<double> calRandomPosition(gsl_rng* rs, SurfaceTypeClass sc);
   Vec3<double> calRandomPosition(gsl_rng* rs);
+  bool isInsideType(Vec3<double> p, SurfaceTypeClass sc);
 
-  bool isInsideVol(float x, float y, float z, float l);
-  inline bool isInsideVol(float x, float y, float z) { return isInsideVol(x, y, z, radius_); }
-  inline bool isInsideSur(float x, float y, float z) {
+  bool isInsideVol(double x, double y, double z, double l);
+  inline bool isInsideVol(double x, double y, double z) { return isInsideVol(x, y, z, radius_); }
+  inline bool isInsideSur(double x, double y, double z) {
     return ((isInsideVol(x,y,z,radius_)) and !isInsideVol(x,y,z,radius_*(1.0-ringDepth_)));
   };
-  bool isInsideDisk(float x, float y, float z);
-  bool isInsideRing(float x, float y, float z);
+  bool isInsideDisk(double x, double y, double z);
+  bool isInsideRing(double x, double y, double z);
 
   Vec3<double> calVolPosition(gsl_rng* rs);
   Vec3<double> calSurPosition(gsl_rng* rs);
@@ -102,11 +104,11 @@ public:
   virtual ~SurfacesCell() {};
 
   // inline functions
-  inline float length() { return length_; }
-  inline float radius() { return radius_; }
-  inline float bandPosition() { return bandPosition_; }
-  inline float bandWidth() { return bandWidth_; }
-  inline float ringDepth() { return ringDepth_; }
+  inline double length() { return length_; }
+  inline double radius() { return radius_; }
+  inline double bandPosition() { return bandPosition_; }
+  inline double bandWidth() { return bandWidth_; }
+  inline double ringDepth() { return ringDepth_; }
   inline size_t ringNumber() { return ringNumber_; }
   inline Vec3<double> maxDimension() {
     return Vec3<double>{length_/2.0+radius_, radius_, radius_}; }
@@ -114,17 +116,17 @@ public:
     return Vec3<double>{-length_/2.0-radius_, -radius_, -radius_}; }
 
 private:
-  float length_;
-  float radius_;
+  double length_;
+  double radius_;
 
-  float bandPosition_;
-  float bandWidth_;
-  float ringDepth_;
+  double bandPosition_;
+  double bandWidth_;
+  double ringDepth_;
   size_t ringNumber_;
 
 };
 
-bool SurfacesCell::isInsideVol(float x, float y, float z, float radius) {
+bool SurfacesCell::isInsideVol(double x, double y, double z, double radius) {
     // container dependent function
     // for cell, 8um length, 2um wide
 
@@ -147,7 +149,7 @@ bool SurfacesCell::isInsideVol(float x, float y, float z, float radius) {
     return false;
 }
 
-bool SurfacesCell::isInsideDisk(float x, float y, float z) {
+bool SurfacesCell::isInsideDisk(double x, double y, double z) {
   if ((x>length_/2.0-bandPosition_*length_-bandWidth_*length_) and (x<length_/2.0-bandPosition_*length_))
     if (sqrt(y*y + z*z) <= radius_-pr_)
       return true;
@@ -155,13 +157,13 @@ bool SurfacesCell::isInsideDisk(float x, float y, float z) {
   return false;
 }
 
-bool SurfacesCell::isInsideRing(float x, float y, float z) {
+bool SurfacesCell::isInsideRing(double x, double y, double z) {
   // check particle center is inside a ring domain
   bool flag = false;
-  float x0; 
+  double x0;
   for (size_t i=0; i < ringNumber_; ++i) {
     if (ringNumber_ > 1)
-      x0 = length_*0.5 + (float)(i) * length_*(1.0 - bandWidth_)/((float)(ringNumber_)- 1.0) - length_*bandWidth_*0.5;
+      x0 = length_*0.5 + (double)(i) * length_*(1.0 - bandWidth_)/((double)(ringNumber_)- 1.0) - length_*bandWidth_*0.5;
     else
       x0 = length_*0.5 - length_*bandWidth_*0.5;
 
@@ -177,7 +179,7 @@ bool SurfacesCell::isInsideRing(float x, float y, float z) {
   return false;
 }
 
-bool SurfacesCell::isInside(float x, float y, float z) {
+bool SurfacesCell::isInside(double x, double y, double z) {
   switch(stype()) {
     case SurfaceTypeClass::volume: return isInsideVol(x, y, z);
     case SurfaceTypeClass::surface: return isInsideSur(x, y, z);
@@ -186,8 +188,18 @@ bool SurfacesCell::isInside(float x, float y, float z) {
   }
 }
 
+bool SurfacesCell::isInsideType(Vec3<double> p, SurfaceTypeClass sc) {
+  switch(sc) {
+    case SurfaceTypeClass::volume: return isInsideVol(p.X(), p.Y(), p.Z());
+    case SurfaceTypeClass::surface: return isInsideSur(p.X(), p.Y(), p.Z());
+    case SurfaceTypeClass::disk: return isInsideDisk(p.X(), p.Y(), p.Z());
+    case SurfaceTypeClass::ring: return isInsideRing(p.X(), p.Y(), p.Z());
+  }
+  return false;
+}
+
 Vec3<double> SurfacesCell::calVolPosition(gsl_rng* rs) {
-    float x,y,z;
+    double x,y,z;
     do {
         x = gsl_rng_uniform(rs)*(length_+2.0*radius_-2.0*pr_)-(length_/2.0+radius_+pr_);
         y = (gsl_rng_uniform(rs)*2.0 - 1.0)*(radius_ - pr_);
@@ -198,7 +210,7 @@ Vec3<double> SurfacesCell::calVolPosition(gsl_rng* rs) {
 }
 
 Vec3<double> SurfacesCell::calSurPosition(gsl_rng* rs) {
-    float x, y, z;
+    double x, y, z;
     do {
       x = gsl_rng_uniform(rs)*(length_+2.0*radius_)-(length_/2.0+radius_);
       y = (gsl_rng_uniform(rs)*2.0 - 1.0)*(radius_ - pr_);
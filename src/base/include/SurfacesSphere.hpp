@@ -21,7 +21,7 @@ class SurfacesSphere: public Surfaces {
 
 public:
   // member functions
-  bool isInside(float x, float y, float z);
+  bool isInside(double x, double y, double z);
   inline bool isInside(Vec3<double> v) { return isInside(v.X(), v.Y(), v.Z()); }
   Vec3<double> calRandomPosition(gsl_rng* rs, SurfaceTypeClass sc=SurfaceTypeClass::volume);
   inline Vec3<double> calRandomPosition(gsl_rng* rs) { return calRandomPosition(rs, SurfaceTypeClass::volume); }
@@ -57,7 +57,7 @@ private:
   double pr_;       // particle radius
 };
 
-bool SurfacesSphere::isInside(float x, float y, float z) {
+bool SurfacesSphere::isInside(double x, double y, double z) {
   Vec3<double> p(x, y, z);
   if (p.mag() < radius_-pr_)
     return true;
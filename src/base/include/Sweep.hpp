@@ -0,0 +1,154 @@
+// Sweep.hpp
+// parameter sweep with common random numbers
+//
+// author: sungcheolkim @ IBM
+// date: 20261018 - initial version (paired rate differences)
+// date: 20261019 - run file names as strings
+// date: 20261019 - runs on MultiRun
+//
+// sweep Key is set to each of sweep Values; every point runs sweep Replicas
+// simulations. replica r has seed + r at all points and keyed Philox streams,
+// so points share injection sites, the uniform draws of every walker and step,
+// and substrate relocation sites. only the swept parameter differs, so the
+// product rate difference to the first point has far less variance than with
+// independent seeds. the per step rate difference (mean over replicas) goes
+// into batch means for its error bar; the unpaired error is shown next to it.
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <iomanip>
+#include "MultiRun.hpp"
+#include "BatchMeans.hpp"
+
+using namespace std;
+
+class Sweep: public MultiRun {
+
+public:
+  // member functions
+  void injectPoints(ParameterReader& pr);
+  void sample(size_t step);
+  void report(bool last);
+
+  // constructor
+  Sweep(ParameterReader& pr, Log* lg): MultiRun{pr, lg, "sweep", "runs"} {
+    cout << blu << "[Sweep] is initialized." << def << endl;
+    key_ = pr.stringRead("sweep Key", "Enzyme Alpha");
+    values_ = pr.arrayRead("sweep Values", "(1.5, 2.0)");
+    replicas_ = max(1, pr.intRead("sweep Replicas", "1"));
+
+    dt_ = pr.doubleRead("dt", "0.0001", false);
+    // same transient as the steady rate of each cloud
+    warmup_ = pr.intRead("converge Warmup", "1000", false);
+  }
+
+  // inline functions
+  inline size_t pointNumber() { return values_.size(); }
+  // run (point, replica) at point*replicas_ + replica
+  inline CloudCell* product(size_t point, size_t replica, size_t i) { return MultiRun::product(point*replicas_ + replica, i); }
+
+private:
+  string key_;
+  vector<string> values_;
+  size_t replicas_;
+  double dt_;
+  size_t warmup_;
+
+  vector<vector<double>> last_;     // product concentration by run and cloud
+  vector<vector<double>> rate_;     // rate of the last step by run and cloud
+  vector<vector<BatchMeans>> diff_; // rate difference to point 0 by point and cloud
+};
+
+void Sweep::injectPoints(ParameterReader& pr) {
+  for (size_t p=0; p < values_.size(); ++p)
+    for (size_t r=0; r < replicas_; ++r) {
+      // <name>_p00_r00.par; common random numbers: same seed and keyed
+      // streams at every point
+      ParameterReader* c = copyParameters(pr, "_p" + numbered(p, 2) + "_r" + numbered(r, 2), seed_ + r);
+      c->set("random Generator", "Philox");
+      c->set(key_, values_[p]);
+      addRun(c);
+    }
+
+  startRuns();
+  last_.assign(runs_.size(), vector<double>(productClouds_.size(), 0.0));
+  rate_.assign(runs_.size(), vector<double>(productClouds_.size(), 0.0));
+  diff_.assign(values_.size(), vector<BatchMeans>(productClouds_.size()));
+
+  cout << "... sweep: " << key_ << " over";
+  for (auto v : values_) cout << " " << v;
+  cout << ", " << replicas_ << " replica(s) per point, " << runs_.size() << " runs on " << pool_->threads() << " thread(s)" << endl;
+
+  // column names
+  ofstream f(saveName_.c_str(), ios::out|ios::trunc);
+  f << "# time point [" << key_ << "] replica";
+  for (size_t i=0; i < productClouds_.size(); ++i) f << " [" << productID(i) << " Product]";
+  f << endl;
+}
+
+void Sweep::sample(size_t step) {
+  // rates of this step, differences paired by replica
+  for (size_t k=0; k < runs_.size(); ++k)
+    for (size_t i=0; i < productClouds_.size(); ++i) {
+      double pc = MultiRun::product(k, i)->productConcentration();
+      rate_[k][i] = (pc - last_[k][i])/dt_;
+      last_[k][i] = pc;
+    }
+  if (step <= warmup_) return;
+
+  for (size_t p=1; p < values_.size(); ++p)
+    for (size_t i=0; i < productClouds_.size(); ++i) {
+      double d = 0.0;
+      for (size_t r=0; r < replicas_; ++r) d += rate_[p*replicas_ + r][i] - rate_[r][i];
+      diff_[p][i].add(d/(double)replicas_);
+    }
+}
+
+void Sweep::report(bool last) {
+  // one line per run in the file, points on screen
+  ofstream f(saveName_.c_str(), ios::out|ios::app);
+  for (size_t k=0; k < runs_.size(); ++k) {
+    f << runs_[k]->time() << " " << k/replicas_ << " " << values_[k/replicas_] << " " << k%replicas_;
+    for (size_t i=0; i < productClouds_.size(); ++i) f << " " << MultiRun::product(k, i)->hitSubstrate();
+    f << endl;
+  }
+
+  for (size_t i=0; i < productClouds_.size(); ++i) {
+    string id = productID(i);
+    // steady rate of a point: mean over replicas, errors added in quadrature
+    vector<double> m(values_.size(), 0.0), se(values_.size(), 0.0);
+    bool ready = true;
+    for (size_t p=0; p < values_.size(); ++p) {
+      double x = 0.0;
+      for (size_t r=0; r < replicas_; ++r) {
+        x += product(p, r, i)->hitSubstrate();
+        BatchMeans* bm = product(p, r, i)->rateStatistics();
+        if ((bm == nullptr) or (bm->batches() < 2)) { ready = false; continue; }
+        m[p] += bm->mean()/(double)replicas_;
+        se[p] += bm->stdError()*bm->stdError();
+      }
+      se[p] = sqrt(se[p])/(double)replicas_;
+      cout << id << " Product [" << key_ << " = " << values_[p] << "]: " << x/(double)replicas_ << endl;
+    }
+    if (!ready) continue;
+
+    for (size_t p=0; p < values_.size(); ++p) {
+      cout << id << " Steady Rate [" << key_ << " = " << values_[p] << "]: " << red << m[p] << def << " +- " << se[p] << " [uM/s]" << endl;
+      if ((p == 0) or (diff_[p][i].batches() < 2)) continue;
+      // unpaired: what independent seeds would give for the same difference
+      double d = diff_[p][i].mean(), sd = diff_[p][i].stdError();
+      double su = sqrt(se[p]*se[p] + se[0]*se[0]);
+      cout << "... difference to " << values_[0] << ": " << red << d << def << " +- " << sd << " [uM/s] (unpaired +- " << su;
+      if (sd > 0.0) cout << ", variance " << su*su/(sd*sd) << "x smaller";
+      cout << ", lag1 " << diff_[p][i].lag1() << ")" << endl;
+      if (last)
+        log_->write(to_string(runs_[0]->time()) + " " + id + " sweep " + key_ + " " + values_[p] + " - " + values_[0]
+                    + " rate " + to_string(m[p]) + " " + to_string(se[p]) + " difference " + to_string(d) + " " + to_string(sd));
+    }
+  }
+}
+
+#endif
+
+// vim:foldmethod=syntax:foldlevel=0
@@ -0,0 +1,259 @@
+// TaskPool.hpp
+// fixed set of threads that run a list of tasks and wait for all of them
+//
+// author: sungcheolkim @ IBM
+// date: 20261018 - initial version
+// date: 20261018 - parallelFor with work stealing
+// date: 20261018 - each thread once (first touch, pinning)
+//
+// run() hands the tasks out one at a time (the calling thread takes tasks as
+// well) and returns when the last one is done, so a simulation step stays one
+// synchronous call. tasks must not share data: order between tasks is not
+// defined.
+//
+// parallelFor(n) runs one task per slot (thread). each slot starts with an
+// equal share of [0, n) and takes chunks of an eighth of what is left in its
+// range (at least grain items); a slot that runs dry steals the back half of
+// the largest range left. expensive items (long walks, many reflections)
+// therefore end up spread over the slots. slot counters (items, chunks,
+// steals, busy time) show how even the load was.
+//
+// each() runs a function once on every thread with its index (0: caller), so
+// slot s of parallelFor is always thread s. pin() keeps thread t on cpu t;
+// pages first touched by thread t then stay close to it.
+
+#ifndef TASKPOOL_H
+#define TASKPOOL_H
+
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <pthread.h>
+#include <sched.h>
+
+using namespace std;
+
+struct TaskSlotStats {
+  uint64_t items = 0;
+  uint64_t chunks = 0;
+  uint64_t steals = 0;
+  double busy = 0.0;            // seconds in items
+};
+
+class TaskPool {
+
+public:
+  // member functions
+  void run(vector<function<void()>>& tasks);
+  void parallelFor(size_t n, size_t grain, function<void(size_t begin, size_t end, size_t slot)> f);
+  void each(function<void(size_t thread)> f);
+  void pin();
+  double utilization();
+  void resetStats();
+
+  // constructor
+  TaskPool(size_t threads): tasks_(nullptr), each_(nullptr), next_(0), left_(0), round_(0), stop_(false),
+    ranges_(max(threads, (size_t)1)), stats_(max(threads, (size_t)1)), wall_(0.0) {
+    for (size_t i=1; i < threads; ++i) workers_.emplace_back(&TaskPool::work, this, i);
+  }
+  TaskPool(const TaskPool& p) = delete;
+  TaskPool& operator=(const TaskPool& p) = delete;
+  virtual ~TaskPool() {
+    { lock_guard<mutex> lk(m_); stop_ = true; }
+    start_.notify_all();
+    for (auto& t : workers_) t.join();
+  }
+
+  // inline functions
+  inline size_t threads() { return workers_.size() + 1; }
+  inline TaskSlotStats& stats(size_t slot) { return stats_[slot]; }
+  inline double wall() { return wall_; }
+
+private:
+  struct Range { mutex m; size_t begin = 0, end = 0; };
+
+  void work(size_t id);
+  bool take(size_t& i);
+  void finish();
+  bool takeChunk(size_t slot, size_t grain, size_t& b, size_t& e);
+
+  vector<thread> workers_;
+  mutex m_;
+  condition_variable start_;
+  condition_variable done_;
+  vector<function<void()>>* tasks_;
+  function<void(size_t)>* each_;  // each(): one call per thread
+  size_t next_;                 // next task to hand out
+  size_t left_;                 // tasks not finished
+  size_t round_;                // run() calls, wakes workers
+  bool stop_;
+
+  vector<Range> ranges_;        // parallelFor: items left per slot
+  vector<TaskSlotStats> stats_;
+  double wall_;                 // seconds in parallelFor
+};
+
+bool TaskPool::take(size_t& i) {
+  lock_guard<mutex> lk(m_);
+  if ((tasks_ == nullptr) or (next_ == tasks_->size())) return false;
+  i = next_++;
+  return true;
+}
+
+void TaskPool::finish() {
+  lock_guard<mutex> lk(m_);
+  if (--left_ == 0) done_.notify_all();
+}
+
+void TaskPool::work(size_t id) {
+  size_t seen = 0;
+  while (true) {
+    function<void(size_t)>* each;
+    {
+      unique_lock<mutex> lk(m_);
+      start_.wait(lk, [&] { return stop_ or (round_ != seen); });
+      if (stop_) return;
+      seen = round_;
+      each = each_;
+    }
+    if (each != nullptr) { (*each)(id); finish(); continue; }
+    size_t i;
+    while (take(i)) { (*tasks_)[i](); finish(); }
+  }
+}
+
+void TaskPool::run(vector<function<void()>>& tasks) {
+  if (tasks.empty()) return;
+  if (workers_.empty() or (tasks.size() == 1)) {
+    for (auto& t : tasks) t();
+    return;
+  }
+  {
+    lock_guard<mutex> lk(m_);
+    tasks_ = &tasks;
+    next_ = 0;
+    left_ = tasks.size();
+    round_++;
+  }
+  start_.notify_all();
+  size_t i;
+  while (take(i)) { tasks[i](); finish(); }
+
+  unique_lock<mutex> lk(m_);
+  done_.wait(lk, [&] { return left_ == 0; });
+  tasks_ = nullptr;
+}
+
+void TaskPool::each(function<void(size_t thread)> f) {
+  if (workers_.empty()) { f(0); return; }
+  {
+    lock_guard<mutex> lk(m_);
+    each_ = &f;
+    left_ = workers_.size() + 1;
+    round_++;
+  }
+  start_.notify_all();
+  f(0);
+  finish();
+
+  unique_lock<mutex> lk(m_);
+  done_.wait(lk, [&] { return left_ == 0; });
+  each_ = nullptr;
+}
+
+void TaskPool::pin() {
+  size_t cpus = max(1u, thread::hardware_concurrency());
+  each([cpus](size_t t) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(t % cpus, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  });
+}
+
+bool TaskPool::takeChunk(size_t slot, size_t grain, size_t& b, size_t& e) {
+  // front of own range, else back half of the largest other range
+  {
+    Range& r = ranges_[slot];
+    lock_guard<mutex> lk(r.m);
+    if (r.begin < r.end) {
+      b = r.begin;
+      e = min(r.end, b + max(grain, (r.end - r.begin)/8));
+      r.begin = e;
+      return true;
+    }
+  }
+  while (true) {
+    size_t victim = slot, most = 0;
+    for (size_t s=0; s < ranges_.size(); ++s) {
+      if (s == slot) continue;
+      lock_guard<mutex> lk(ranges_[s].m);
+      size_t left = ranges_[s].end - ranges_[s].begin;
+      if (left > most) { most = left; victim = s; }
+    }
+    if (most == 0) return false;
+
+    Range& v = ranges_[victim];
+    unique_lock<mutex> lk(v.m);
+    size_t left = v.end - v.begin;
+    if (left == 0) continue;      // taken meanwhile
+    size_t mid = v.begin + ((left > grain) ? left/2 : 0);
+    b = mid;
+    e = v.end;
+    v.end = mid;
+    lk.unlock();
+    stats_[slot].steals++;
+
+    // keep all but the first chunk in own range for others to steal
+    size_t first = min(e, b + max(grain, (e - b)/8));
+    Range& r = ranges_[slot];
+    lock_guard<mutex> lr(r.m);
+    r.begin = first;
+    r.end = e;
+    e = first;
+    return true;
+  }
+}
+
+void TaskPool::parallelFor(size_t n, size_t grain, function<void(size_t begin, size_t end, size_t slot)> f) {
+  auto t0 = chrono::steady_clock::now();
+  size_t p = ranges_.size();
+  grain = max(grain, (size_t)1);
+  for (size_t s=0; s < p; ++s) {
+    ranges_[s].begin = n*s/p;
+    ranges_[s].end = n*(s+1)/p;
+  }
+
+  each([this, grain, &f](size_t s) {
+    size_t b, e;
+    while (takeChunk(s, grain, b, e)) {
+      auto c0 = chrono::steady_clock::now();
+      f(b, e, s);
+      stats_[s].busy += chrono::duration<double>(chrono::steady_clock::now() - c0).count();
+      stats_[s].items += e - b;
+      stats_[s].chunks++;
+    }
+  });
+  wall_ += chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+}
+
+double TaskPool::utilization() {
+  // busy time of all slots over the time they were available
+  double busy = 0.0;
+  for (auto& s : stats_) busy += s.busy;
+  return (wall_ > 0.0) ? busy/(wall_*(double)stats_.size()) : 0.0;
+}
+
+void TaskPool::resetStats() {
+  for (auto& s : stats_) s = TaskSlotStats{};
+  wall_ = 0.0;
+}
+
+#endif
+
+// vim:foldmethod=syntax:foldlevel=0
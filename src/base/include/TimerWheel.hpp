@@ -0,0 +1,110 @@
+// TimerWheel.hpp
+// hierarchical timer wheel of items due at integer steps
+//
+// author: sungcheolkim @ IBM
+// date: 20261018 - initial version (4 levels of 256 slots)
+//
+// an item due in d steps goes to the lowest level whose span covers d. when
+// level 0 wraps, the next slot of level 1 is spread over level 0, and so on,
+// so insert and expiry are O(1) per item. items due beyond 2^32 steps wait
+// in a list that is checked when the top level wraps.
+
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+template <class T>
+class TimerWheel {
+
+public:
+  // member functions
+  void insert(T item, uint64_t due);
+  void advance(uint64_t now, vector<T>& expired);
+  void clear();
+
+  // constructor
+  TimerWheel(): now_(0), size_(0) { clear(); }
+  virtual ~TimerWheel() { };
+
+  // inline functions
+  inline size_t size() { return size_; }
+  inline uint64_t now() { return now_; }
+
+private:
+  static const int bits_ = 8;
+  static const int levels_ = 4;
+  static const uint64_t slots_ = 1u << bits_;
+
+  void place(pair<T, uint64_t> e, vector<T>& expired);
+  void cascade(int level, vector<T>& expired);
+
+  uint64_t now_;
+  size_t size_;
+  vector<pair<T, uint64_t>> wheel_[levels_][slots_];
+  vector<pair<T, uint64_t>> far_;
+};
+
+template <class T>
+void TimerWheel<T>::clear() {
+  for (int l=0; l < levels_; ++l)
+    for (uint64_t s=0; s < slots_; ++s) wheel_[l][s].clear();
+  far_.clear();
+  size_ = 0;
+}
+
+template <class T>
+void TimerWheel<T>::place(pair<T, uint64_t> e, vector<T>& expired) {
+  if (e.second <= now_) { expired.push_back(e.first); size_--; return; }
+  uint64_t d = e.second - now_;
+  for (int l=0; l < levels_; ++l)
+    if (d < (1ull << (bits_*(l+1)))) {
+      wheel_[l][(e.second >> (bits_*l)) & (slots_-1)].push_back(e);
+      return;
+    }
+  far_.push_back(e);
+}
+
+template <class T>
+void TimerWheel<T>::insert(T item, uint64_t due) {
+  vector<T> none;
+  size_++;
+  place(make_pair(item, due), none);
+}
+
+template <class T>
+void TimerWheel<T>::cascade(int level, vector<T>& expired) {
+  // slot of the new time at this level moves down
+  auto& slot = wheel_[level][(now_ >> (bits_*level)) & (slots_-1)];
+  vector<pair<T, uint64_t>> moving;
+  moving.swap(slot);
+  for (auto& e : moving) place(e, expired);
+}
+
+template <class T>
+void TimerWheel<T>::advance(uint64_t now, vector<T>& expired) {
+  // items due at or before now, in steps of one
+  while (now_ < now) {
+    now_++;
+    for (int l=1; l < levels_; ++l) {
+      if (now_ & ((1ull << (bits_*l)) - 1)) break;
+      cascade(l, expired);
+      if ((l == levels_-1) and !far_.empty()) {
+        vector<pair<T, uint64_t>> moving;
+        moving.swap(far_);
+        for (auto& e : moving) place(e, expired);
+      }
+    }
+    auto& slot = wheel_[0][now_ & (slots_-1)];
+    for (auto& e : slot) expired.push_back(e.first);
+    size_ -= slot.size();
+    slot.clear();
+  }
+}
+
+#endif
+
+// vim:foldmethod=syntax:foldlevel=0
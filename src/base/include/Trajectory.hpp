@@ -0,0 +1,526 @@
+// Trajectory.hpp
+// columnar trajectory file (.ptc) with frame index
+//
+// author: sungcheolkim @ IBM
+// date: 20261018 - initial version (writer, mmap reader)
+// date: 20261018 - compressed frames (version 2)
+//
+// file layout (little endian, every section starts at a multiple of 8 bytes)
+//   header   TrajectoryHeader, then one TrajectoryColumn (name, numpy dtype)
+//            per column
+//   frames   TrajectoryFrameHeader, then the columns of the frame one after
+//            the other (n values each, padded to 8 bytes)
+//   index    one TrajectoryIndex per frame
+//   trailer  TrajectoryTrailer (index offset, frame number, "PTCINDEX")
+// index and trailer are written on close. a file without trailer (crashed
+// run) is read by walking the frame headers. columns are plain arrays, so
+// readers map the file and use the columns without copying (numpy.frombuffer).
+//
+// version 2 (compressed) has a TrajectoryCodecHeader after the columns. the
+// column table gives the decoded types. positions are quantized to the
+// resolution and stored as differences to the last position of the same tid,
+// pid likewise, tid (first) as difference to the previous tid in the frame
+// (packed columns of TrajectoryCodec.hpp). durations are stored as (gap, value) pairs
+// of the walkers with non zero duration. every chunk frames starts from zero
+// positions (key frame), so a frame is decoded from its key frame on.
+
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include "Vec3.hpp"
+#include "TrajectoryCodec.hpp"
+
+using namespace std;
+
+struct TrajectoryHeader {
+  char magic[8];                // "LEVYPTC1"
+  uint32_t version;
+  uint32_t columns;
+  double r;                     // walker radius [um]
+  char cloudID[32];
+  uint64_t headerSize;          // offset of the first frame
+};
+
+struct TrajectoryCodecHeader {
+  double resolution;            // position grid [um]
+  uint32_t chunk;               // frames from one key frame to the next
+  uint32_t codec;               // 1: delta, packed
+};
+
+struct TrajectoryColumn {
+  char name[12];
+  char dtype[4];                // numpy dtype: <f8, <u4, |u1
+};
+
+struct TrajectoryFrameHeader {
+  double t;
+  uint64_t step;
+  uint64_t n;                   // walkers in frame
+  uint64_t bytes;               // frame size with this header
+};
+
+struct TrajectoryIndex {
+  double t;
+  uint64_t step;
+  uint64_t n;
+  uint64_t offset;              // frame header offset
+};
+
+struct TrajectoryTrailer {
+  uint64_t indexOffset;
+  uint64_t frames;
+  char magic[8];                // "PTCINDEX"
+};
+
+static_assert(sizeof(TrajectoryHeader) == 64, "trajectory header layout");
+static_assert(sizeof(TrajectoryColumn) == 16, "trajectory column layout");
+static_assert(sizeof(TrajectoryCodecHeader) == 16, "trajectory codec layout");
+static_assert(sizeof(TrajectoryFrameHeader) == 32, "trajectory frame layout");
+static_assert(sizeof(TrajectoryIndex) == 32, "trajectory index layout");
+static_assert(sizeof(TrajectoryTrailer) == 24, "trajectory trailer layout");
+
+// columns written by TrajectoryWriter
+const TrajectoryColumn trajectoryColumns[] = {
+  {"x", "<f8"}, {"y", "<f8"}, {"z", "<f8"}, {"duration", "<f8"},
+  {"tid", "<u4"}, {"pid", "|u1"}
+};
+
+inline size_t trajectoryPad(size_t bytes) { return (bytes + 7)/8*8; }
+
+// size of one value of a dtype (last character)
+inline size_t trajectoryItemSize(const char* dtype) {
+  return (size_t)(dtype[2] - '0');
+}
+
+// one frame in the mapped file - pointers into the map
+struct TrajectoryFrame {
+  double t;
+  size_t step;
+  size_t n;
+  const double* x;
+  const double* y;
+  const double* z;
+  const double* duration;
+  const uint32_t* tid;
+  const uint8_t* pid;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+class TrajectoryWriter {
+
+public:
+  // member functions
+  void beginFrame(double t, size_t step);
+  void endFrame();
+  void close();
+
+  // constructor - resolution > 0: compressed frames
+  TrajectoryWriter(string fn, string cloudID, double r, double resolution=0.0, size_t chunk=64) :
+    offset_(0),
+    resolution_(resolution),
+    chunk_(max((size_t)1, chunk)) {
+    file_.open(fn.c_str(), ios::out|ios::binary|ios::trunc);
+    if (!file_.good()) {
+      cerr << "... cannot open trajectory file " << fn << endl;
+      exit(1);
+    }
+
+    TrajectoryHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, "LEVYPTC1", 8);
+    h.version = (resolution_ > 0.0) ? 2 : 1;
+    h.columns = sizeof(trajectoryColumns)/sizeof(TrajectoryColumn);
+    h.r = r;
+    strncpy(h.cloudID, cloudID.c_str(), sizeof(h.cloudID)-1);
+    h.headerSize = sizeof(h) + h.columns*sizeof(TrajectoryColumn);
+    if (h.version == 2) h.headerSize += sizeof(TrajectoryCodecHeader);
+    file_.write((const char*)&h, sizeof(h));
+    file_.write((const char*)trajectoryColumns, h.columns*sizeof(TrajectoryColumn));
+    if (h.version == 2) {
+      TrajectoryCodecHeader ch{resolution_, (uint32_t)chunk_, 1};
+      file_.write((const char*)&ch, sizeof(ch));
+    }
+    offset_ = h.headerSize;
+  }
+  TrajectoryWriter(const TrajectoryWriter& w) = delete;
+  TrajectoryWriter& operator=(const TrajectoryWriter& w) = delete;
+  virtual ~TrajectoryWriter() { close(); }
+
+  // inline functions
+  inline void add(Vec3<double> p, double duration, size_t tid, size_t pid) {
+    x_.push_back(p.X()); y_.push_back(p.Y()); z_.push_back(p.Z());
+    duration_.push_back(duration);
+    tid_.push_back((uint32_t)tid);
+    pid_.push_back((uint8_t)pid);
+  }
+  inline size_t frames() { return index_.size(); }
+  inline uint64_t bytes() { return offset_; }
+
+private:
+  template <typename T> void writeColumn(vector<T>& v);
+  void encodeFrame();
+
+  ofstream file_;
+  uint64_t offset_;
+  double resolution_;
+  size_t chunk_;
+  TrajectoryIndex frame_;
+  vector<TrajectoryIndex> index_;
+
+  // columns of the current frame (reused)
+  vector<double> x_, y_, z_, duration_;
+  vector<uint32_t> tid_;
+  vector<uint8_t> pid_;
+
+  // compressed frames: last values by tid, codes and output (reused)
+  vector<int64_t> qx_, qy_, qz_;
+  vector<uint8_t> qpid_;
+  vector<uint64_t> zz_;
+  vector<uint8_t> buf_;
+};
+
+void TrajectoryWriter::beginFrame(double t, size_t step) {
+  frame_.t = t;
+  frame_.step = step;
+  x_.clear(); y_.clear(); z_.clear(); duration_.clear();
+  tid_.clear(); pid_.clear();
+}
+
+template <typename T>
+void TrajectoryWriter::writeColumn(vector<T>& v) {
+  static const char zero[8] = {0};
+  size_t bytes = v.size()*sizeof(T);
+  file_.write((const char*)v.data(), bytes);
+  file_.write(zero, trajectoryPad(bytes) - bytes);
+}
+
+void TrajectoryWriter::encodeFrame() {
+  size_t n = x_.size();
+
+  // key frame - differences to zero
+  if (index_.size()%chunk_ == 0) {
+    fill(qx_.begin(), qx_.end(), 0); fill(qy_.begin(), qy_.end(), 0);
+    fill(qz_.begin(), qz_.end(), 0); fill(qpid_.begin(), qpid_.end(), 0);
+  }
+  size_t m = 0;
+  for (auto t : tid_) m = max(m, (size_t)t + 1);
+  if (m > qx_.size()) {
+    qx_.resize(m, 0); qy_.resize(m, 0); qz_.resize(m, 0); qpid_.resize(m, 0);
+  }
+
+  buf_.clear();
+  zz_.resize(n);
+  int64_t prev = -1;
+  for (size_t k=0; k < n; ++k) { zz_[k] = zigzag((int64_t)tid_[k] - prev); prev = tid_[k]; }
+  putPacked(buf_, zz_);
+
+  vector<double>* xyz[3] = {&x_, &y_, &z_};
+  vector<int64_t>* last[3] = {&qx_, &qy_, &qz_};
+  for (int a=0; a < 3; ++a) {
+    for (size_t k=0; k < n; ++k) {
+      int64_t q = llround((*xyz[a])[k]/resolution_);
+      int64_t& l = (*last[a])[tid_[k]];
+      zz_[k] = zigzag(q - l);
+      l = q;
+    }
+    putPacked(buf_, zz_);
+  }
+  for (size_t k=0; k < n; ++k) {
+    zz_[k] = zigzag((int64_t)pid_[k] - qpid_[tid_[k]]);
+    qpid_[tid_[k]] = pid_[k];
+  }
+  putPacked(buf_, zz_);
+
+  // durations of bound walkers only
+  size_t count = 0;
+  for (auto d : duration_) if (d != 0.0) count++;
+  putVarint(buf_, count);
+  size_t gap = 0;
+  for (size_t k=0; k < n; ++k) {
+    if (duration_[k] == 0.0) continue;
+    putVarint(buf_, k - gap);
+    gap = k;
+    size_t at = buf_.size();
+    buf_.resize(at + sizeof(double));
+    memcpy(buf_.data() + at, &duration_[k], sizeof(double));
+  }
+}
+
+void TrajectoryWriter::endFrame() {
+  size_t n = x_.size();
+
+  if (resolution_ > 0.0) {
+    encodeFrame();
+    TrajectoryFrameHeader fh{frame_.t, frame_.step, n, sizeof(TrajectoryFrameHeader) + trajectoryPad(buf_.size())};
+    file_.write((const char*)&fh, sizeof(fh));
+    writeColumn(buf_);
+    frame_.n = n;
+    frame_.offset = offset_;
+    index_.push_back(frame_);
+    offset_ += fh.bytes;
+    return;
+  }
+
+  TrajectoryFrameHeader fh{frame_.t, frame_.step, n, sizeof(TrajectoryFrameHeader)};
+  fh.bytes += 4*trajectoryPad(n*sizeof(double)) + trajectoryPad(n*sizeof(uint32_t))
+    + trajectoryPad(n*sizeof(uint8_t));
+
+  file_.write((const char*)&fh, sizeof(fh));
+  writeColumn(x_); writeColumn(y_); writeColumn(z_); writeColumn(duration_);
+  writeColumn(tid_); writeColumn(pid_);
+
+  frame_.n = n;
+  frame_.offset = offset_;
+  index_.push_back(frame_);
+  offset_ += fh.bytes;
+}
+
+void TrajectoryWriter::close() {
+  if (!file_.is_open()) return;
+
+  TrajectoryTrailer tr;
+  tr.indexOffset = offset_;
+  tr.frames = index_.size();
+  memcpy(tr.magic, "PTCINDEX", 8);
+  file_.write((const char*)index_.data(), index_.size()*sizeof(TrajectoryIndex));
+  file_.write((const char*)&tr, sizeof(tr));
+  file_.close();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+class TrajectoryReader {
+
+public:
+  // member functions
+  TrajectoryFrame frame(size_t i);
+  size_t findTime(double t);
+
+  // constructor
+  TrajectoryReader(string fn) :
+    base_(nullptr), size_(0), index_(nullptr), frames_(0), decoded_((size_t)-1) {
+    int fd = open(fn.c_str(), O_RDONLY);
+    struct stat st;
+    if ((fd < 0) or (fstat(fd, &st) != 0) or ((size_t)st.st_size < sizeof(TrajectoryHeader))) {
+      cerr << "... cannot read trajectory file " << fn << endl;
+      exit(1);
+    }
+    size_ = st.st_size;
+    void* m = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (m == MAP_FAILED) {
+      cerr << "... cannot map trajectory file " << fn << endl;
+      exit(1);
+    }
+    base_ = (const char*)m;
+
+    memcpy(&h_, base_, sizeof(h_));
+    if (memcmp(h_.magic, "LEVYPTC1", 8) != 0) {
+      cerr << "... not a trajectory file " << fn << endl;
+      exit(1);
+    }
+    codec_ = TrajectoryCodecHeader{0.0, 1, 0};
+    if (h_.version == 2)
+      memcpy(&codec_, base_ + sizeof(h_) + h_.columns*sizeof(TrajectoryColumn), sizeof(codec_));
+    setColumns();
+    setIndex();
+  }
+  TrajectoryReader(const TrajectoryReader& r) = delete;
+  TrajectoryReader& operator=(const TrajectoryReader& r) = delete;
+  virtual ~TrajectoryReader() { if (base_ != nullptr) munmap((void*)base_, size_); }
+
+  // inline functions
+  inline size_t frames() { return frames_; }
+  inline const TrajectoryIndex& index(size_t i) { return index_[i]; }
+  inline string cloudID() { return string(h_.cloudID); }
+  inline double r() { return h_.r; }
+  inline bool indexed() { return scanned_.empty() and (frames_ > 0); }
+  inline bool compressed() { return h_.version == 2; }
+  inline double resolution() { return codec_.resolution; }
+  inline size_t chunk() { return codec_.chunk; }
+
+private:
+  void setColumns();
+  void setIndex();
+  void decodeFrame(size_t i);
+  size_t frameBytes(size_t n);
+  const void* column(const char* base, size_t n, int k);
+
+  const char* base_;
+  size_t size_;
+  TrajectoryHeader h_;
+  vector<TrajectoryColumn> columns_;
+  int col_[6];                          // x, y, z, duration, tid, pid in file
+  const TrajectoryIndex* index_;        // in map or scanned_
+  size_t frames_;
+  vector<TrajectoryIndex> scanned_;
+
+  // compressed frames: decoded frame and last values by tid
+  TrajectoryCodecHeader codec_;
+  size_t decoded_;
+  vector<double> x_, y_, z_, duration_;
+  vector<uint32_t> tid_;
+  vector<uint8_t> pid_;
+  vector<int64_t> qx_, qy_, qz_;
+  vector<uint8_t> qpid_;
+  vector<uint64_t> zz_;
+};
+
+void TrajectoryReader::setColumns() {
+  const TrajectoryColumn* c = (const TrajectoryColumn*)(base_ + sizeof(TrajectoryHeader));
+  columns_.assign(c, c + h_.columns);
+
+  // find known columns by name and type
+  size_t known = sizeof(trajectoryColumns)/sizeof(TrajectoryColumn);
+  for (size_t k=0; k < known; ++k) {
+    col_[k] = -1;
+    for (size_t j=0; j < columns_.size(); ++j)
+      if ((strncmp(columns_[j].name, trajectoryColumns[k].name, 12) == 0)
+          and (strncmp(columns_[j].dtype, trajectoryColumns[k].dtype, 4) == 0))
+        col_[k] = (int)j;
+  }
+}
+
+void TrajectoryReader::setIndex() {
+  // index from trailer
+  if (size_ >= h_.headerSize + sizeof(TrajectoryTrailer)) {
+    TrajectoryTrailer tr;
+    memcpy(&tr, base_ + size_ - sizeof(tr), sizeof(tr));
+    if ((memcmp(tr.magic, "PTCINDEX", 8) == 0)
+        and (tr.indexOffset + tr.frames*sizeof(TrajectoryIndex) + sizeof(tr) == size_)) {
+      index_ = (const TrajectoryIndex*)(base_ + tr.indexOffset);
+      frames_ = tr.frames;
+      return;
+    }
+  }
+
+  // no trailer - walk frame headers up to the last complete frame
+  cout << "... no frame index, scan frames" << endl;
+  size_t offset = h_.headerSize;
+  while (offset + sizeof(TrajectoryFrameHeader) <= size_) {
+    const TrajectoryFrameHeader* fh = (const TrajectoryFrameHeader*)(base_ + offset);
+    bool sized = compressed() ? ((fh->bytes > sizeof(TrajectoryFrameHeader)) and (fh->bytes%8 == 0))
+                              : (fh->bytes == frameBytes(fh->n));
+    if (!sized or (offset + fh->bytes > size_)) break;
+    scanned_.push_back(TrajectoryIndex{fh->t, fh->step, fh->n, offset});
+    offset += fh->bytes;
+  }
+  index_ = scanned_.data();
+  frames_ = scanned_.size();
+}
+
+size_t TrajectoryReader::frameBytes(size_t n) {
+  size_t bytes = sizeof(TrajectoryFrameHeader);
+  for (auto& c : columns_) bytes += trajectoryPad(n*trajectoryItemSize(c.dtype));
+  return bytes;
+}
+
+const void* TrajectoryReader::column(const char* base, size_t n, int k) {
+  if (k < 0) return nullptr;
+  size_t offset = 0;
+  for (int j=0; j < k; ++j)
+    offset += trajectoryPad(n*trajectoryItemSize(columns_[j].dtype));
+  return base + offset;
+}
+
+void TrajectoryReader::decodeFrame(size_t i) {
+  const TrajectoryIndex& ix = index_[i];
+  const uint8_t* p = (const uint8_t*)(base_ + ix.offset + sizeof(TrajectoryFrameHeader));
+  size_t n = ix.n;
+  double res = codec_.resolution;
+
+  if (i%codec_.chunk == 0) {
+    fill(qx_.begin(), qx_.end(), 0); fill(qy_.begin(), qy_.end(), 0);
+    fill(qz_.begin(), qz_.end(), 0); fill(qpid_.begin(), qpid_.end(), 0);
+  }
+
+  getPacked(p, n, zz_);
+  tid_.resize(n);
+  int64_t prev = -1;
+  size_t m = 0;
+  for (size_t k=0; k < n; ++k) {
+    prev += unzigzag(zz_[k]);
+    tid_[k] = (uint32_t)prev;
+    m = max(m, (size_t)prev + 1);
+  }
+  if (m > qx_.size()) {
+    qx_.resize(m, 0); qy_.resize(m, 0); qz_.resize(m, 0); qpid_.resize(m, 0);
+  }
+
+  vector<double>* xyz[3] = {&x_, &y_, &z_};
+  vector<int64_t>* last[3] = {&qx_, &qy_, &qz_};
+  for (int a=0; a < 3; ++a) {
+    getPacked(p, n, zz_);
+    xyz[a]->resize(n);
+    for (size_t k=0; k < n; ++k) {
+      int64_t& l = (*last[a])[tid_[k]];
+      l += unzigzag(zz_[k]);
+      (*xyz[a])[k] = l*res;
+    }
+  }
+  getPacked(p, n, zz_);
+  pid_.resize(n);
+  for (size_t k=0; k < n; ++k) {
+    qpid_[tid_[k]] = (uint8_t)(qpid_[tid_[k]] + unzigzag(zz_[k]));
+    pid_[k] = qpid_[tid_[k]];
+  }
+
+  duration_.assign(n, 0.0);
+  size_t count = getVarint(p);
+  size_t k = 0;
+  for (size_t j=0; j < count; ++j) {
+    k += getVarint(p);
+    memcpy(&duration_[k], p, sizeof(double));
+    p += sizeof(double);
+  }
+  decoded_ = i;
+}
+
+TrajectoryFrame TrajectoryReader::frame(size_t i) {
+  const TrajectoryIndex& ix = index_[i];
+  if (compressed()) {
+    // continue from the decoded frame in the same chunk or from the key frame
+    size_t key = i - i%codec_.chunk;
+    size_t from = ((decoded_ != (size_t)-1) and (decoded_ >= key) and (decoded_ <= i)) ? decoded_ + 1 : key;
+    if (decoded_ == i) from = i + 1;
+    for (size_t j=from; j <= i; ++j) decodeFrame(j);
+    return TrajectoryFrame{ix.t, ix.step, ix.n, x_.data(), y_.data(), z_.data(),
+      duration_.data(), tid_.data(), pid_.data()};
+  }
+
+  const char* data = base_ + ix.offset + sizeof(TrajectoryFrameHeader);
+  size_t n = ix.n;
+
+  TrajectoryFrame f;
+  f.t = ix.t;
+  f.step = ix.step;
+  f.n = n;
+  f.x = (const double*)column(data, n, col_[0]);
+  f.y = (const double*)column(data, n, col_[1]);
+  f.z = (const double*)column(data, n, col_[2]);
+  f.duration = (const double*)column(data, n, col_[3]);
+  f.tid = (const uint32_t*)column(data, n, col_[4]);
+  f.pid = (const uint8_t*)column(data, n, col_[5]);
+  return f;
+}
+
+size_t TrajectoryReader::findTime(double t) {
+  // first frame at or after t (frames are in time order)
+  const TrajectoryIndex* p = lower_bound(index_, index_ + frames_, t,
+      [](const TrajectoryIndex& a, double b) { return a.t < b; });
+  return p - index_;
+}
+
+#endif
+
+// vim:foldmethod=syntax:foldlevel=0
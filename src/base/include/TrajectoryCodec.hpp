@@ -0,0 +1,90 @@
+// TrajectoryCodec.hpp
+// integer codec for compressed trajectory frames
+//
+// author: sungcheolkim @ IBM
+// date: 20261018 - initial version (zigzag, varint, frame of reference bit packing)
+//
+// a packed column is varint(base), one byte bit width w and n values of w
+// bits (little endian bit order, padded to a byte). values are zigzag codes
+// minus base, so columns of small deltas take a few bits per value and
+// constant columns take none.
+
+#ifndef TRAJECTORYCODEC_H
+#define TRAJECTORYCODEC_H
+
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+inline uint64_t zigzag(int64_t v) { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+inline int64_t unzigzag(uint64_t u) { return (int64_t)(u >> 1) ^ -(int64_t)(u & 1); }
+
+inline void putVarint(vector<uint8_t>& out, uint64_t v) {
+  while (v >= 0x80) { out.push_back((uint8_t)(v | 0x80)); v >>= 7; }
+  out.push_back((uint8_t)v);
+}
+
+inline uint64_t getVarint(const uint8_t*& p) {
+  uint64_t v = 0;
+  for (int s=0; ; s += 7) {
+    uint8_t b = *p++;
+    v |= (uint64_t)(b & 0x7f) << s;
+    if (b < 0x80) return v;
+  }
+}
+
+// zigzag codes of one column
+inline void putPacked(vector<uint8_t>& out, const vector<uint64_t>& zz) {
+  uint64_t base = zz.empty() ? 0 : zz[0];
+  uint64_t top = base;
+  for (auto u : zz) { if (u < base) base = u; if (u > top) top = u; }
+  int w = 0;
+  while ((w < 64) and ((top - base) >> w)) w++;
+
+  putVarint(out, base);
+  out.push_back((uint8_t)w);
+  if (w == 0) return;
+
+  // bit stream - acc keeps up to 7 pending bits and one value
+  size_t start = out.size();
+  out.resize(start + (zz.size()*w + 7)/8, 0);
+  uint8_t* q = out.data() + start;
+  size_t bit = 0;
+  for (auto u : zz) {
+    uint64_t v = u - base;
+    for (int done=0; done < w; ) {
+      int s = bit & 7;
+      int take = min(8 - s, w - done);
+      q[bit >> 3] |= (uint8_t)(((v >> done) & ((1u << take) - 1)) << s);
+      bit += take;
+      done += take;
+    }
+  }
+}
+
+inline void getPacked(const uint8_t*& p, size_t n, vector<uint64_t>& zz) {
+  uint64_t base = getVarint(p);
+  int w = *p++;
+  zz.assign(n, base);
+  if (w == 0) return;
+
+  size_t bit = 0;
+  for (size_t k=0; k < n; ++k) {
+    uint64_t v = 0;
+    for (int done=0; done < w; ) {
+      int s = bit & 7;
+      int take = min(8 - s, w - done);
+      v |= (uint64_t)((p[bit >> 3] >> s) & ((1u << take) - 1)) << done;
+      bit += take;
+      done += take;
+    }
+    zz[k] += v;
+  }
+  p += (n*w + 7)/8;
+}
+
+#endif
+
+// vim:foldmethod=syntax:foldlevel=0
@@ -0,0 +1,58 @@
+// UniformGrid.hpp
+// cell geometry shared by CellList and LocationGrid
+//
+// author: sungcheolkim @ IBM
+// date: 20261019 - initial version (from CellList and LocationGrid)
+//
+// cubic cells of width h from lo. h is not smaller than the cutoff, but
+// large enough for about one item per cell. cell (ix, iy, iz) has index
+// (iz*ny + iy)*nx + ix; positions outside the grid go to the border cells.
+
+#ifndef UNIFORMGRID_H
+#define UNIFORMGRID_H
+
+#include <algorithm>
+#include <math.h>
+#include "Vec3.hpp"
+
+using namespace std;
+
+class UniformGrid {
+
+public:
+  // member functions
+  void setGrid(Vec3<double> lo, Vec3<double> hi, double h, size_t n);
+
+  // constructor
+  UniformGrid(double h): h_(h), nx_(1), ny_(1), nz_(1) { }
+  virtual ~UniformGrid() { };
+
+  // inline functions
+  inline size_t cellOf(Vec3<double> p) {
+    return (size_t)((clamp((p.Z()-lo_.Z())/h_, nz_)*ny_ + clamp((p.Y()-lo_.Y())/h_, ny_))*nx_
+                    + clamp((p.X()-lo_.X())/h_, nx_));
+  }
+  inline size_t cellNumber() { return (size_t)(nx_*ny_*nz_); }
+  inline double h() { return h_; }
+
+protected:
+  inline long clamp(double v, long n) { return min(max((long)floor(v), 0L), n-1); }
+
+  Vec3<double> lo_;
+  double h_;
+  long nx_, ny_, nz_;
+};
+
+void UniformGrid::setGrid(Vec3<double> lo, Vec3<double> hi, double h, size_t n) {
+  Vec3<double> ext = hi - lo;
+  double hmin = pow(ext.X()*ext.Y()*ext.Z()/max(n, (size_t)1), 1.0/3.0);
+  h_ = max(h, hmin);
+  lo_ = lo;
+  nx_ = max(1L, (long)ceil(ext.X()/h_));
+  ny_ = max(1L, (long)ceil(ext.Y()/h_));
+  nz_ = max(1L, (long)ceil(ext.Z()/h_));
+}
+
+#endif
+
+// vim:foldmethod=syntax:foldlevel=0
@@ -29,6 +29,13 @@ template <class T> class Vec3 {
         Vec3(Vec3<T>&& v) { this->x = v.x; this->y = v.y; this->z = v.z; }
         Vec3<T>& operator=(Vec3<T>&&) = default;
 
+        // Conversion from another scalar type (float storage, double arithmetic)
+        template <class U> explicit Vec3(const Vec3<U>& v) {
+            x = static_cast<T>(v.X());
+            y = static_cast<T>(v.Y());
+            z = static_cast<T>(v.Z());
+        }
+
         // ------------ Getters and setters ------------
 
         void set(const T &xValue, const T &yValue, const T &zValue) {
@@ -3,23 +3,60 @@
 // author: sungcheolkim @ IBM
 // date: 2016/02/01
 // date: 2017/09/12 - reconstruct class structure
+// date: 20261018 - compact record (one cache line per walker)
+// date: 20261018 - records live in pools of the cloud
+// date: 20261018 - position scalar real_t (SINGLE_PRECISION: float)
+// date: 20261018 - walker count shared by concurrent cells
+// date: 20261019 - unnamed parameters of placement new/delete
+// date: 20261019 - no trace in walker statistics
+//
+// a walker keeps only what differs between walkers of a cloud: position,
+// index (tid), partition (pid) and the counters of the subclasses. radius,
+// volume, mass, partition thresholds and time are kept in the cloud.
+// statistics that are not always needed (last hit) are attached by the cloud
+// on first use. walkers of a cloud are placed in its pool (clone(slot)),
+// so a walker does not own its statistics.
+//
+// positions are stored as real_t and handed out as Vec3<double>, so steps are
+// added in double and rounded once. with SINGLE_PRECISION (float) a base
+// walker takes 48 bytes and an enzyme 56 instead of a 64 byte cache line.
 
 #ifndef WALKER_H
 #define WALKER_H
 
+#include <stdint.h>
+#include <ostream>
+#include <atomic>
 #include "Vec3.hpp"
 #include "ParameterReader.h"
 
 using namespace std;
 
+#ifdef SINGLE_PRECISION
+typedef float real_t;
+#else
+typedef double real_t;
+#endif
+
+// cache line for double records, packed for float records
+constexpr size_t walkerAlignment = (sizeof(real_t) == sizeof(double)) ? 64 : 8;
+
+// optional per-walker attributes
+struct WalkerStats {
+  double lastHitAge = 0.0;
+  Vec3<double> lastHitPosition;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
-class Walker
+class alignas(walkerAlignment) Walker
 {
 public:
-  // virtual functions
-  virtual void setProperties(ParameterReader& pr, string cloudID) = 0;
-  virtual void write(string filename) = 0;
+  virtual ~Walker() { }
 
+  // virtual functions
+  virtual void write(ostream& file, double t, double r) = 0;
+  virtual Walker* clone() = 0;
+  virtual Walker* clone(void* slot) = 0;
   virtual void addWallHit(size_t i) = 0;
   virtual size_t wallHit() = 0;
   virtual size_t substrateHit() = 0;
@@ -27,58 +64,42 @@ public:
   virtual double duration() = 0;
   virtual void duration(double d) = 0;
   virtual void subDuration(double dt) = 0;
-  virtual double r() = 0;
-  virtual double volume() = 0;
-  virtual double mass() = 0;
-  virtual double lastHitAge() = 0;
-  virtual void lastHitAge(double a) = 0;
-  virtual Vec3<double> lastHitPosition() = 0;
-  virtual void lastHitPosition(Vec3<double> p) = 0;
 
-  // member functions
-  void step(Vec3<double> dr);
-  size_t calPID(Vec3<double> p);
-  inline size_t calPID() { return calPID(position_); }
-  void setPIDRange(double x1, double x2, double x3, double y1, double z1);
+  // cache line aligned allocation
+  static void* operator new(size_t n);
+  static void operator delete(void* p);
+  static void* operator new(size_t, void* slot) { return slot; }
+  static void operator delete(void*, void*) { }
+
+  // constructor
+  Walker() : stats_(nullptr), tid_(0), pid_(0) { count_++; }
+  Walker(const Walker& w) :
+    position_(w.position_), stats_(nullptr), tid_(w.tid_), pid_(w.pid_) { count_++; }
+  Walker& operator=(const Walker& w) = delete;
 
   // inline functions
-  inline Vec3<double> position() { return position_; }
-  inline void position(Vec3<double> p) { positionn_ = position_; position_ = p; }
-  inline Vec3<double> positionn() { return positionn_; }
-  inline double age() { return age_; }
-  inline void age(double a) { age_ = a; }
-  inline void addAge(double dt) { age_ += dt; }
-  inline double trace() { return trace_; }
-  inline void trace(double l) { trace_ = l; }
-  inline void addTrace(double l) { trace_ += l; }
+  inline Vec3<double> position() { return Vec3<double>(position_); }
+  inline void position(Vec3<double> p) { position_ = Vec3<real_t>(p); }
+  inline void step(Vec3<double> dr) { position_ = Vec3<real_t>(position() + dr); }
   inline size_t tid() { return tid_; }
-  inline void tid(size_t t) { tid_ = t; }
+  inline void tid(size_t t) { tid_ = (uint32_t)t; }
   inline size_t pid() { return pid_; }
-  inline void pid(size_t t) { pid_ = t; }
-  inline string ID() { return walkerID_; }
-  inline void ID(string s) { walkerID_ = s; }
+  inline void pid(size_t t) { pid_ = (uint8_t)t; }
+  inline bool hasStats() { return stats_ != nullptr; }
+  inline WalkerStats* stats() { return stats_; }
+  inline void stats(WalkerStats* s) { stats_ = s; }
   inline size_t walkerSize() { return count_; }
-  inline string cloudID() { return cloudID_; }
-  inline void cloudID(string s) { cloudID_ = s; }
 
 protected:
-  string walkerID_;
-  string cloudID_;
-  Vec3<double> position_;
-  Vec3<double> positionn_;
-  double age_;
-  double trace_;
-  size_t tid_;
-
-  size_t pid_;    // process id for virtual space
-  double px1_, px2_, px3_;
-  double py1_;
-  double pz1_;
-
-  static unsigned int count_;
+  Vec3<real_t> position_;
+  WalkerStats* stats_;
+  uint32_t tid_;
+  uint8_t pid_;     // process id for virtual space
 
+  static atomic<unsigned int> count_;
 };
 /////////////////////////////////////////////////////////////////////////////
+
 #endif
 
 // vim: foldmethod=syntax:foldlevel=1
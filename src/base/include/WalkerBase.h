@@ -18,63 +18,39 @@ class WalkerBase : public Walker
 {
 public:
   // member functions
-  void setProperties(ParameterReader& pr, string cloudID);
-  void write(string filename);
+  void write(ostream& file, double t, double r);
+  inline Walker* clone() { return new WalkerBase{*this}; }
+  inline Walker* clone(void* slot) { return new (slot) WalkerBase{*this}; }
 
   // constructor
-  WalkerBase(double xi, double yi, double zi) : 
-    r_(1.0), wallHit_(0), lastHitAge_(0.0) {
+  WalkerBase(double xi, double yi, double zi) :
+    wallHit_(0) {
     Vec3<double> p{xi, yi, zi};
     //cout << "[Walker(" << count_ << ")] is initialized at " << position_ << endl;
     position(p);
-    age(0.0);
-    trace(0.0);
-    ID("WalkerBase");
-    positionn_ = p;
-    count_++;
   }
   WalkerBase(Vec3<double> v) : WalkerBase(v.X(), v.Y(), v.Z()) { }
   WalkerBase() : WalkerBase(0.0, 0.0, 0.0) { }
+  WalkerBase(const WalkerBase& w) = default;
   virtual ~WalkerBase() { }
 
   // inline member functions
-  //Vec3<double> position0() { return position0_; }
-  //void position0(Vec3<double> v) { position0_ = v; }
-  inline double r() { return r_; }
-  inline void r(double r) { r_=r; }
-  inline double volume() { return volume_; }
-  inline void volume(double v) { volume_ = v; }
-
   inline size_t wallHit() { return wallHit_; }
-  inline void wallHit(size_t h) { wallHit_ = h; }
-  inline void addWallHit(size_t i) { wallHit_ += i; }
-
+  inline void wallHit(size_t h) { wallHit_ = (uint32_t)h; }
+  inline void addWallHit(size_t i) { wallHit_ += (uint32_t)i; }
   inline size_t substrateHit() { return 0; }
   inline void addSubstrateHit(size_t hit) { return; }
   inline double duration() { return 0; }
   inline void duration(double d) { return; }
   inline void subDuration(double dt) { return; }
-  inline double lastHitAge() { return lastHitAge_; }
-  inline void lastHitAge(double a) { lastHitAge_ = a; }
-  inline Vec3<double> lastHitPosition() { return lastHitPosition_; }
-  inline void lastHitPosition(Vec3<double> p) { lastHitPosition_ = p; }
-
-  inline double mass() { return 0.0; }
 
 protected:
-  double r_;
-  size_t wallHit_;
-  double volume_;
-  double lastHitAge_;
-
-  Vec3<double> lastHitPosition_;
-  // reserved for MSD calculation
-  //Vec3<double> position0_;
+  uint32_t wallHit_;
 
 private:
-
 };
 /////////////////////////////////////////////////////////////////////////////
+
 #endif
 
 // vim: foldmethod=syntax:foldlevel=1
@@ -5,6 +5,7 @@
 // date: 20160202
 // date: 20160619 version: 1.1.0 update: define class
 // date: 20170912 - rewritten for new class
+// date: 20261018 - mass moved to cloud
 
 #ifndef WALKERENZYME_H
 #define WALKERENZYME_H
@@ -20,42 +21,40 @@ class WalkerEnzyme : public WalkerBase
 {
 public:
   // member functions
-  void setProperties(ParameterReader& pr, string cloudID);
+  inline Walker* clone() { return new WalkerEnzyme{*this}; }
+  inline Walker* clone(void* slot) { return new (slot) WalkerEnzyme{*this}; }
 
   // constructor
   WalkerEnzyme() : WalkerEnzyme(0.0, 0.0, 0.0) { }
   WalkerEnzyme(Vec3<double> v) : WalkerEnzyme(v.X(), v.Y(), v.Z()) { }
   WalkerEnzyme(double xi, double yi, double zi) :
     WalkerBase(xi, yi, zi),
-    duration_(0),
-    substrateHit_(0)
+    substrateHit_(0),
+    duration_(0)
   {
     //cout << "[Walker(" << count_ << ")] is initialized at " << position_ << endl;
-    ID("WalkerEnzyme");
   }
+  WalkerEnzyme(const WalkerEnzyme& w) = default;
   virtual ~WalkerEnzyme() { }
 
   size_t substrateHit() { return substrateHit_; }
-  void substrateHit(size_t hit) { substrateHit_ = hit; }
-  void addSubstrateHit(size_t hit) { substrateHit_ += hit; }
-
+  void substrateHit(size_t hit) { substrateHit_ = (uint32_t)hit; }
+  void addSubstrateHit(size_t hit) { substrateHit_ += (uint32_t)hit; }
   double duration() { return duration_; }
   void duration(double d) { duration_ = d; }
   void subDuration(double dt) { duration_ -= dt; }
 
-  double mass() { return mass_; }
-  void mass(double m) { mass_ = m; }
-
 protected:
-
+  // counter first - fills the tail of WalkerBase
+  uint32_t substrateHit_;
   double duration_;
-  size_t substrateHit_;
-  double mass_;
 
 private:
-
-
 };
 /////////////////////////////////////////////////////////////////////////////
+
+static_assert(sizeof(WalkerEnzyme) <= 64, "walker record should fit in one cache line");
+
 #endif
+
 // vim: foldmethod=syntax
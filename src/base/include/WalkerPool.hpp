@@ -0,0 +1,144 @@
+// WalkerPool.hpp
+// block allocator for walker records owned by a cloud
+//
+// author: sungcheolkim @ IBM
+// date: 20261018 - initial version (aligned blocks, free list)
+// date: 20261018 - slot size of the record type
+// date: 20261018 - blocks from a memory policy
+// date: 20261019 - reserve counts the free list
+// date: 20261019 - blocks of whole huge pages with a memory policy
+//
+// slots of one size are carved from large aligned blocks. released slots go
+// to a free list (the first word of a free slot points to the next one), so
+// walkers removed by reactions are reused by products. objects in the pool
+// are not destructed on clear: everything they own must come from pools of
+// the same cloud. clear and the destructor free only the blocks. with a
+// memory policy, blocks fill whole huge pages, backed by huge pages and first
+// touched by threads as the policy says.
+
+#ifndef WALKERPOOL_H
+#define WALKERPOOL_H
+
+#include <stdlib.h>
+#include <vector>
+#include <algorithm>
+#include <new>
+#include <iostream>
+#include "MemoryPolicy.hpp"
+
+using namespace std;
+
+class WalkerPool {
+public:
+  // member functions
+  void* allocate();
+  void release(void* p);
+  void reserve(size_t n);
+  void clear();
+  void slotSize(size_t n);
+  void placement(MemoryPlacement& mp);
+
+  // constructor
+  WalkerPool(size_t slotSize, size_t alignment, size_t blockSlots=4096) :
+    slotSize_(slotSize),
+    alignment_(alignment),
+    blockSlots_(blockSlots),
+    next_(nullptr),
+    end_(nullptr),
+    used_(0),
+    free_(nullptr),
+    policy_(nullptr) {
+    this->slotSize(slotSize);
+  }
+  WalkerPool(const WalkerPool& p) = delete;
+  WalkerPool& operator=(const WalkerPool& p) = delete;
+  virtual ~WalkerPool() { clear(); }
+
+  // inline functions
+  inline size_t slotSize() { return slotSize_; }
+  inline size_t used() { return used_; }
+  inline size_t capacity() { return count_; }
+  inline size_t bytes() { return capacity()*slotSize_; }
+  inline void policy(MemoryPolicy* p) { policy_ = p; }
+
+private:
+  void addBlock(size_t slots);
+
+  size_t slotSize_;
+  size_t alignment_;
+  size_t blockSlots_;
+  char* next_;                // next fresh slot in last block
+  char* end_;
+  size_t used_;
+  void* free_;                // released slots
+  size_t freeCount_ = 0;      // slots in free list
+  MemoryPolicy* policy_;      // nullptr: heap blocks
+  vector<MemoryBlock> blocks_;
+  size_t count_ = 0;          // slots in all blocks
+};
+
+void WalkerPool::addBlock(size_t slots) {
+  if (policy_ != nullptr) slots = policy_->blockSlots(slots, slotSize_);
+  size_t bytes = slots*slotSize_;
+  MemoryBlock b = (policy_ != nullptr) ? policy_->allocate(bytes, alignment_) : MemoryPolicy::plain(bytes, alignment_);
+  blocks_.push_back(b);
+  next_ = (char*)b.p;
+  end_ = next_ + slots*slotSize_;
+  count_ += slots;
+}
+
+void* WalkerPool::allocate() {
+  used_++;
+  if (free_ != nullptr) {
+    void* p = free_;
+    free_ = *(void**)p;
+    freeCount_--;
+    return p;
+  }
+  if (next_ == end_) addBlock(blockSlots_);
+  void* p = next_;
+  next_ += slotSize_;
+  return p;
+}
+
+void WalkerPool::release(void* p) {
+  *(void**)p = free_;
+  free_ = p;
+  freeCount_++;
+  used_--;
+}
+
+void WalkerPool::reserve(size_t n) {
+  // one block for all missing slots - the rest of the last block is left
+  // unused, so the free list and the new block alone must hold them
+  size_t left = (end_ - next_)/slotSize_;
+  if (n > used_ + freeCount_ + left) addBlock(max(n - used_ - freeCount_, blockSlots_));
+}
+
+void WalkerPool::slotSize(size_t n) {
+  // slot holds the free list pointer and keeps the alignment; fixed once
+  // blocks exist
+  if (count_ > 0) {
+    cerr << "... walker pool: slot size set after allocation" << endl;
+    exit(1);
+  }
+  slotSize_ = (max(n, sizeof(void*)) + alignment_ - 1)/alignment_*alignment_;
+}
+
+void WalkerPool::placement(MemoryPlacement& mp) {
+  for (auto& b : blocks_) MemoryPolicy::placement(b, mp);
+}
+
+void WalkerPool::clear() {
+  for (auto& b : blocks_) MemoryPolicy::release(b);
+  blocks_.clear();
+  next_ = end_ = nullptr;
+  free_ = nullptr;
+  freeCount_ = 0;
+  used_ = 0;
+  count_ = 0;
+}
+
+#endif
+
+// vim:foldmethod=syntax:foldlevel=0
@@ -0,0 +1,206 @@
+// WeightedEnsemble.hpp
+// split and merge of weighted enzymes along a progress coordinate
+//
+// author: sungcheolkim @ IBM
+// date: 20261018 - initial version (Huber-Kim resampling)
+// date: 20261019 - substrate relocation by replica weight
+//
+// moving walkers of one enzyme cloud are binned every "ensemble Interval"
+// steps by a progress coordinate: distance to the nearest substrate
+// (Substrate) or to the substrate band of the cell along x (Band). a bin with
+// too many walkers merges its two lightest ones (one survives with probability
+// by weight and takes both weights), a bin with too few splits its heaviest
+// one into two halves (record copy in a new slot). total weight stays the
+// number of enzymes, so products counted by weight are unbiased while walkers
+// near substrates are sampled more often. bound walkers are not resampled.
+// a replica of weight w moves the substrate it hits with probability w, so
+// sites move as often as with unweighted enzymes.
+// product rate and its error bars come from the batch means of the cloud.
+
+#ifndef WEIGHTEDENSEMBLE_H
+#define WEIGHTEDENSEMBLE_H
+
+#include <vector>
+#include <algorithm>
+#include <math.h>
+#include <gsl/gsl_rng.h>
+#include "Vec3.hpp"
+#include "ParameterReader.h"
+#include "CloudCell.hpp"
+#include "SurfacesCell.hpp"
+
+using namespace std;
+
+class WeightedEnsemble {
+
+public:
+  // member functions
+  void resample(size_t step);
+  double coordinate(Walker* w);
+  void info();
+
+  // constructor
+  WeightedEnsemble(ParameterReader& pr, vector<Cloud*>& clouds, unsigned long int seed):
+    cloud_(nullptr), band_(nullptr), splits_(0), merges_(0)
+  {
+    cout << blu << "[WeightedEnsemble] is initialized." << def << endl;
+    string name = pr.stringRead("ensemble Cloud", "Enzyme");
+    for (auto c : clouds)
+      if (c->cloudID() == name) cloud_ = dynamic_cast<CloudCell*>(c);
+    if ((cloud_ == nullptr) or (cloud_->substrateCloud() == nullptr)) {
+      cerr << "... ensemble Cloud needs a particle cloud with substrate: " << name << endl;
+      exit(1);
+    }
+    // weighted replicas must not use up shared substrates
+    if (!cloud_->substrateConstant()) {
+      cerr << "... ensemble needs " << name << " Substrate Constant: True" << endl;
+      exit(1);
+    }
+
+    coordinate_ = pr.stringRead("ensemble Coordinate", "Substrate");
+    if (coordinate_.find("Band") != string::npos) {
+      band_ = dynamic_cast<SurfacesCell*>(cloud_->sf());
+      if (band_ == nullptr) {
+        cerr << "... ensemble Coordinate: Band needs Cell surface" << endl;
+        exit(1);
+      }
+    } else if (cloud_->field() != nullptr) {
+      cerr << "... ensemble Coordinate: Substrate needs substrate particles" << endl;
+      exit(1);
+    }
+
+    // bin edges [nm] -> [um], bins below, between and above
+    for (auto e : pr.arrayRead("ensemble Bins", "(5, 10, 20, 40)"))
+      edges_.push_back(stod(e)/1000.0);
+    sort(edges_.begin(), edges_.end());
+    target_ = pr.intRead("ensemble Walkers Per Bin", "10");
+    interval_ = max(1, pr.intRead("ensemble Interval", "10"));
+    minWeight_ = pr.doubleRead("ensemble Min Weight", "1e-12");
+
+    // own stream: survivors do not shift the walker streams
+    rs_ = gsl_rng_alloc(gsl_rng_mt19937);
+    gsl_rng_set(rs_, seed);
+    cloud_->weighted(true);
+    count_.resize(edges_.size()+1, 0);
+
+    cout << "... ensemble: " << name << " by " << coordinate_ << " in " << count_.size()
+         << " bins, " << target_ << " walkers per bin every " << interval_ << " steps" << endl;
+  }
+  WeightedEnsemble(const WeightedEnsemble& w) = delete;
+  WeightedEnsemble& operator=(const WeightedEnsemble& w) = delete;
+  virtual ~WeightedEnsemble() { gsl_rng_free(rs_); }
+
+  // inline functions
+  inline size_t interval() { return interval_; }
+
+private:
+  CloudCell* cloud_;
+  SurfacesCell* band_;
+  string coordinate_;
+  vector<double> edges_;          // bin edges [um]
+  size_t target_;
+  size_t interval_;
+  double minWeight_;
+  gsl_rng* rs_;
+
+  vector<vector<Walker*>> bins_;
+  vector<size_t> count_;          // walkers per bin at last resample
+  vector<size_t> list_;
+  vector<size_t> cells_;
+  vector<Walker*> removed_;
+  size_t splits_;
+  size_t merges_;
+};
+
+double WeightedEnsemble::coordinate(Walker* w) {
+  Vec3<double> p = w->position();
+
+  // distance along x to the band, 0 inside
+  if (band_ != nullptr) {
+    double hi = band_->length()/2.0 - band_->bandPosition()*band_->length();
+    double lo = hi - band_->bandWidth()*band_->length();
+    return (p.X() < lo) ? lo - p.X() : (p.X() > hi) ? p.X() - hi : 0.0;
+  }
+
+  // nearest substrate in the cell neighbourhood: exact below the cell width,
+  // farther ones land in the last bins anyway
+  Cloud* sc = cloud_->substrateCloud();
+  sc->getLocationList(p, Vec3<double>(0.0, 0.0, 0.0), list_, cells_);
+  double d = HUGE_VAL;
+  for (auto i : list_) d = min(d, ((*sc)[i]->position() - p).mag());
+  return d;
+}
+
+void WeightedEnsemble::resample(size_t step) {
+  if (step%interval_ != 0) return;
+  if (band_ == nullptr) cloud_->substrateCloud()->prepareLocationList(cloud_->sightDistance());
+
+  bins_.assign(edges_.size()+1, vector<Walker*>{});
+  for (auto w : cloud_->wlist()) {
+    if (w->duration() > 0.0) continue;
+    double x = coordinate(w);
+    bins_[upper_bound(edges_.begin(), edges_.end(), x) - edges_.begin()].push_back(w);
+  }
+
+  // lightest first, ties by tid
+  auto lighter = [this](Walker* a, Walker* b) {
+    double wa = cloud_->weight(a), wb = cloud_->weight(b);
+    return (wa < wb) or ((wa == wb) and (a->tid() < b->tid()));
+  };
+  removed_.clear();
+  for (size_t b=0; b < bins_.size(); ++b) {
+    auto& v = bins_[b];
+    if (v.empty()) { count_[b] = 0; continue; }
+    sort(v.begin(), v.end(), lighter);
+
+    while (v.size() > target_) {
+      Walker* a = v[0];
+      Walker* c = v[1];
+      double wa = cloud_->weight(a), wc = cloud_->weight(c);
+      bool keepA = (gsl_rng_uniform(rs_)*(wa + wc) < wa);
+      Walker* keep = keepA ? a : c;
+      removed_.push_back(keepA ? c : a);
+      cloud_->weight(keep, wa + wc);
+      v.erase(v.begin(), v.begin()+2);
+      v.insert(upper_bound(v.begin(), v.end(), keep, lighter), keep);
+      merges_++;
+    }
+
+    while (v.size() < target_) {
+      Walker* h = v.back();
+      double wh = cloud_->weight(h)/2.0;
+      if (wh < minWeight_) break;
+      v.pop_back();
+      Walker* c = cloud_->splitWalker(h);
+      cloud_->weight(h, wh);
+      cloud_->weight(c, wh);
+      v.insert(upper_bound(v.begin(), v.end(), h, lighter), h);
+      v.insert(upper_bound(v.begin(), v.end(), c, lighter), c);
+      splits_++;
+    }
+    count_[b] = v.size();
+  }
+
+  // removeWalker moves the last walker into the index: from the back
+  sort(removed_.begin(), removed_.end(), [](Walker* a, Walker* b) { return a->tid() > b->tid(); });
+  for (auto w : removed_) cloud_->removeWalker(w->tid());
+}
+
+void WeightedEnsemble::info() {
+  double total = 0.0, lo = HUGE_VAL, hi = 0.0;
+  for (auto w : cloud_->wlist()) {
+    double x = cloud_->weight(w);
+    total += x;
+    lo = min(lo, x);
+    hi = max(hi, x);
+  }
+  cout << "Ensemble: " << cloud_->size() << " walkers, weight " << total << " (" << lo << " - " << hi
+       << "), splits " << splits_ << " merges " << merges_ << endl;
+  cout << "... walkers per bin:";
+  for (auto n : count_) cout << " " << n;
+  cout << endl;
+}
+
+#endif
+
+// vim:foldmethod=syntax:foldlevel=0
@@ -0,0 +1,570 @@
+// WellMixed.hpp
+// stochastic reference solvers from the same parameter file
+//
+// author: sungcheolkim @ IBM
+// date: 20261018 - initial version (next reaction method, next subvolume method)
+// date: 20261019 - second order rates from the per step rule, focus concentration
+// date: 20261019 - rdme picks only reactions and species with positive rate
+//
+// NRM treats the cell as one well-mixed volume (Gibson-Bruck next reaction
+// method with an indexed heap of putative times). RDME splits the surface
+// into cubic voxels (next subvolume method): molecules jump to inside
+// neighbors with rate D/h^2 and react with the local volume.
+//
+// reactions are built from the same keys as the particle run:
+//   enzyme clouds with "Substrate On" give E + S -> E + P with the MM rate
+//   Kcat [E][S]/([S] + [E] + Km) printed in CloudCell::setSubstrateCloud
+//   ([E] is "Focus Concentration" when it is not 0).
+//   "reaction Names" rules (Reactions.hpp) give first order rates and second
+//   order rates from the per step rule: a B within d of the segment that A
+//   walked in dt fires with probability p, so k = p (4/3 pi d^3 + pi d^2 L)/dt
+//   with the mean step length L = 4 sqrt(D_A dt/pi) of a gaussian step.
+// counts are written at every "info Cycle" in the _count.txt format of
+// CloudCell and in the _reaction_count.txt format of Reactions.
+
+#ifndef WELLMIXED_H
+#define WELLMIXED_H
+
+#include <vector>
+#include <limits>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <math.h>
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_randist.h>
+#include <gsl/gsl_const_num.h>
+#include <gsl/gsl_const_mksa.h>
+#include "ParameterReader.h"
+#include "Surfaces.hpp"
+#include "SurfacesSphere.hpp"
+#include "SurfacesBox.hpp"
+#include "SurfacesCell.hpp"
+
+using namespace std;
+
+// binary heap of putative times with position index for updates
+class IndexedHeap {
+
+public:
+  void init(vector<double>& t);
+  void update(size_t i, double t);
+  inline size_t top() { return heap_[0]; }
+  inline double time(size_t i) { return t_[i]; }
+
+private:
+  void up(size_t k);
+  void down(size_t k);
+  void swapNode(size_t a, size_t b);
+
+  vector<double> t_;
+  vector<size_t> heap_;
+  vector<size_t> pos_;
+};
+
+void IndexedHeap::init(vector<double>& t) {
+  t_ = t;
+  heap_.resize(t.size());
+  pos_.resize(t.size());
+  for (size_t i=0; i < t.size(); ++i) { heap_[i] = i; pos_[i] = i; }
+  for (size_t k=heap_.size()/2+1; k-- > 0;) down(k);
+}
+
+void IndexedHeap::update(size_t i, double t) {
+  t_[i] = t;
+  up(pos_[i]);
+  down(pos_[i]);
+}
+
+void IndexedHeap::swapNode(size_t a, size_t b) {
+  swap(heap_[a], heap_[b]);
+  pos_[heap_[a]] = a;
+  pos_[heap_[b]] = b;
+}
+
+void IndexedHeap::up(size_t k) {
+  while ((k > 0) and (t_[heap_[(k-1)/2]] > t_[heap_[k]])) {
+    swapNode(k, (k-1)/2);
+    k = (k-1)/2;
+  }
+}
+
+void IndexedHeap::down(size_t k) {
+  while (true) {
+    size_t m = k, l = 2*k+1, r = 2*k+2;
+    if ((l < heap_.size()) and (t_[heap_[l]] < t_[heap_[m]])) m = l;
+    if ((r < heap_.size()) and (t_[heap_[r]] < t_[heap_[m]])) m = r;
+    if (m == k) return;
+    swapNode(k, m);
+    k = m;
+  }
+}
+
+struct WMSpecies {
+  string name;
+  Surfaces* sf;
+  double D;                   // [um2/s]
+  long n0;
+};
+
+struct WMReaction {
+  string name;
+  vector<size_t> reactant;
+  vector<pair<size_t, long>> change;    // (species, delta)
+  double k;                   // [1/s] or [um3/s]
+  bool mm;                    // Michaelis-Menten enzyme reaction
+  double Km, Kcat;            // [uM], [1/s]
+  double focus;               // enzyme concentration [uM] (0: from count)
+  size_t pid;                 // enzyme-substrate pair for count file
+};
+
+class WellMixed {
+
+public:
+  // member functions
+  void runNRM();
+  void runRDME();
+
+  // constructor
+  WellMixed(ParameterReader& pr, gsl_rng* rs):
+    rs_(rs)
+  {
+    cout << blu << "[WellMixed] is initialized." << def << endl;
+
+    dt_ = pr.doubleRead("dt", "0.0001");
+    tmax_ = dt_*pr.intRead("iteration", "1000");
+    tout_ = dt_*pr.intRead("info Cycle", "100");
+    h_ = pr.doubleRead("solver Voxel Size", "100")/1000.0;     // [nm] -> [um]
+
+    for (auto name : pr.arrayRead("species Name", "(Enzyme, Substrate)"))
+      addSpecies(pr, name);
+    V_ = slist_[0].sf->volume();
+    cout << "... cal Volume: " << gre << V_ << def << " [um3]" << endl;
+
+    // enzyme - substrate pairs
+    for (size_t e=0; e < slist_.size(); ++e) {
+      string ename = slist_[e].name;
+      if (!pr.boolRead(ename+" Substrate On", "False", false)) continue;
+      if (!pr.boolRead(ename+" Reaction On", "True", false)) continue;
+      string sname = pr.stringRead(ename+" Substrate Name", "Substrate", false);
+      size_t s = speciesIndex(sname);
+
+      WMReaction rx;
+      rx.name = ename + "-" + sname;
+      rx.reactant = {e, s};
+      rx.mm = true;
+      rx.k = 0.0;
+      rx.Km = pr.doubleRead(ename+" Km", "8.9", false);
+      rx.Kcat = pr.doubleRead(ename+" Kcat", "6.3", false);
+      // same default as CloudCell: cluster reaction with fixed enzyme concentration
+      rx.focus = pr.doubleRead(ename+" Focus Concentration", "1.0", false);
+      // product is counted, substrate removed unless constant
+      if (!pr.boolRead(ename+" Substrate Constant", "True", false))
+        rx.change.push_back(make_pair(s, -1L));
+      rx.pid = pairs_.size();
+      pairs_.push_back(make_pair(e, s));
+      rlist_.push_back(rx);
+      cout << "... add MM reaction " << rx.name << " Km: " << gre << rx.Km << def << " Kcat: " << gre << rx.Kcat << def << endl;
+    }
+
+    // reaction table
+    if (pr.boolRead("reaction On", "False", false))
+      for (auto name : pr.arrayRead("reaction Names", "(R1)", false))
+        addRule(pr, name);
+
+    if (rlist_.size() == 0) {
+      cerr << "... no reaction for well-mixed solver" << endl;
+      exit(1);
+    }
+
+    string tmp = pr.simfilename();
+    if (tmp.find(".par") != string::npos)
+      basename_ = tmp.substr(0, tmp.find(".par"));
+    else if (tmp.find(".txt") != string::npos)
+      basename_ = tmp.substr(0, tmp.find(".txt"));
+    else
+      basename_ = tmp;
+  }
+  virtual ~WellMixed() {
+    for (auto& s : slist_) delete s.sf;
+  }
+
+private:
+  void addSpecies(ParameterReader& pr, string name);
+  void addRule(ParameterReader& pr, string name);
+  size_t speciesIndex(string name);
+  double propensity(WMReaction& rx, vector<long>& n, double V);
+  void fire(size_t j, vector<long>& n);
+  void openCount(string method);
+  void writeCount(double t, vector<long>& n);
+
+  gsl_rng* rs_;
+  double dt_;
+  double tmax_;
+  double tout_;
+  double h_;
+  double V_;
+  string basename_;
+  vector<WMSpecies> slist_;
+  vector<WMReaction> rlist_;
+  vector<pair<size_t, size_t>> pairs_;    // (enzyme, substrate)
+  vector<size_t> product_;                // product count per pair
+  vector<size_t> fired_;                  // fire count per reaction
+  string countName_;
+  string reactionCountName_;
+};
+
+void WellMixed::addSpecies(ParameterReader& pr, string name) {
+  WMSpecies s;
+  s.name = name;
+
+  string shape = pr.stringRead(name+" Surface Shape", "Sphere");
+  if (shape.find("Sphere") != string::npos) {
+    s.sf = new SurfacesSphere{pr, name};
+  } else if (shape.find("Box") != string::npos) {
+    s.sf = new SurfacesBox{pr, name};
+  } else if (shape.find("Cell") != string::npos) {
+    s.sf = new SurfacesCell{pr, name};
+  } else {
+    cerr << "... not know surface shape type: " << shape << " from (Sphere, Box, Cell)" << endl;
+    exit(1);
+  }
+
+  // same conversion as CloudBase
+  double r = pr.doubleRead(name+" Particle Radius", "1")/1000.0;
+  if (pr.checkName(name+" Diffusion Constant")) {
+    s.D = pr.doubleRead(name+" Diffusion Constant", "1.0");
+  } else {
+    double viscosity = pr.doubleRead(name+" Viscosity", "0.001");
+    double temperature = pr.doubleRead(name+" Temperature", "300");
+    s.D = GSL_CONST_MKSA_BOLTZMANN*temperature*1e18/(6.0*M_PI*viscosity*r);
+  }
+
+  if (pr.checkName(name+" Particle Number"))
+    s.n0 = pr.intRead(name+" Particle Number", "1");
+  else if (pr.checkName(name+" Concentration"))
+    s.n0 = (long)(pr.doubleRead(name+" Concentration", "1.0")*s.sf->volume()*GSL_CONST_NUM_AVOGADRO*1e-21);
+  else
+    s.n0 = pr.intRead(name+" Particle Number", "100");
+
+  cout << "... add " << name << " N: " << gre << s.n0 << def << " D: " << gre << s.D << def << " [um2/s]" << endl;
+  slist_.push_back(s);
+}
+
+size_t WellMixed::speciesIndex(string name) {
+  for (size_t k=0; k < slist_.size(); ++k)
+    if (slist_[k].name == name) return k;
+  cerr << "... no species " << name << endl;
+  exit(1);
+}
+
+void WellMixed::addRule(ParameterReader& pr, string name) {
+  string eq = pr.stringRead(name+" Equation", "Enzyme + Substrate -> Enzyme + Product");
+  bool reversible = (eq.find("<->") != string::npos);
+  auto found = eq.find(reversible ? "<->" : "->");
+  if (found == string::npos) {
+    cerr << "... reaction equation format: A + B -> C " << eq << endl;
+    exit(1);
+  }
+
+  auto parse = [this](string s) {
+    vector<size_t> side;
+    stringstream ss(s);
+    string item;
+    while (getline(ss, item, '+')) {
+      item.erase(0, item.find_first_not_of(" \t"));
+      item.erase(item.find_last_not_of(" \t\n\r")+1);
+      if (item.empty() or (item == "0")) continue;
+      side.push_back(speciesIndex(item));
+    }
+    return side;
+  };
+  auto make = [this](string n, vector<size_t> lhs, vector<size_t> rhs, double k) {
+    WMReaction rx;
+    rx.name = n;
+    rx.reactant = lhs;
+    rx.mm = false;
+    rx.k = k;
+    rx.focus = 0.0;
+    rx.pid = string::npos;
+    vector<long> delta(slist_.size(), 0);
+    for (auto s : lhs) delta[s]--;
+    for (auto s : rhs) delta[s]++;
+    for (size_t s=0; s < delta.size(); ++s)
+      if (delta[s] != 0) rx.change.push_back(make_pair(s, delta[s]));
+    rlist_.push_back(rx);
+    cout << "... add reaction " << n << " k: " << gre << k << def << ((lhs.size() == 2) ? " [um3/s]" : " [1/s]") << endl;
+  };
+
+  vector<size_t> lhs = parse(eq.substr(0, found));
+  vector<size_t> rhs = parse(eq.substr(found + (reversible ? 3 : 2)));
+  if (lhs.size() == 2) {
+    double d = pr.doubleRead(name+" Reaction Distance", "5")/1000.0;
+    double p = pr.doubleRead(name+" Probability", "1.0");
+    // volume swept by A in one step, B positions uniform
+    double L = 4.0*sqrt(slist_[lhs[0]].D*dt_/M_PI);
+    make(name, lhs, rhs, p*(4.0/3.0*M_PI*d*d*d + M_PI*d*d*L)/dt_);
+  } else if (lhs.size() == 1) {
+    make(name, lhs, rhs, pr.doubleRead(name+" Rate", "1.0"));
+  } else {
+    cerr << "... reaction needs one or two reactants: " << eq << endl;
+    exit(1);
+  }
+  if (reversible)
+    make(name+"r", rhs, lhs, pr.doubleRead(name+" Unbinding Rate", "1.0"));
+}
+
+double WellMixed::propensity(WMReaction& rx, vector<long>& n, double V) {
+  // V [um3] -> number per uM
+  double nuM = V*GSL_CONST_NUM_AVOGADRO*1e-21;
+
+  if (rx.mm) {
+    double e = (rx.focus > 0.0) ? rx.focus : n[rx.reactant[0]]/nuM;
+    double s = n[rx.reactant[1]]/nuM;
+    if ((e == 0.0) or (s == 0.0)) return 0.0;
+    return rx.Kcat*e*s/(s + e + rx.Km)*nuM;
+  }
+  if (rx.reactant.size() == 1)
+    return rx.k*n[rx.reactant[0]];
+  if (rx.reactant[0] == rx.reactant[1])
+    return rx.k*n[rx.reactant[0]]*(n[rx.reactant[0]] - 1)/(2.0*V);
+  return rx.k*n[rx.reactant[0]]*n[rx.reactant[1]]/V;
+}
+
+void WellMixed::fire(size_t j, vector<long>& n) {
+  for (auto& c : rlist_[j].change) n[c.first] += c.second;
+  if (rlist_[j].pid != string::npos) product_[rlist_[j].pid]++;
+  fired_[j]++;
+}
+
+void WellMixed::openCount(string method) {
+  countName_ = basename_ + "_" + method + "_count.txt";
+  reactionCountName_ = basename_ + "_" + method + "_reaction_count.txt";
+  product_.assign(pairs_.size(), 0);
+  fired_.assign(rlist_.size(), 0);
+
+  fstream f;
+  f.open(countName_, ios::out);
+  f.close();
+  f.open(reactionCountName_, ios::out);
+  f << "# time";
+  for (auto& s : slist_) f << " " << s.name;
+  for (auto& rx : rlist_) f << " " << rx.name;
+  f << endl;
+  f.close();
+}
+
+void WellMixed::writeCount(double t, vector<long>& n) {
+  double NA = GSL_CONST_NUM_AVOGADRO*1e-21;
+  fstream f;
+
+  // CloudCell format: age, enzyme, substrate (local) and product concentration [uM]
+  f.open(countName_, ios::out|ios::app);
+  for (size_t k=0; k < pairs_.size(); ++k) {
+    WMSpecies& e = slist_[pairs_[k].first];
+    WMSpecies& s = slist_[pairs_[k].second];
+    f << t << " " << n[pairs_[k].first]/(e.sf->typeVolume()*NA) << " "
+      << n[pairs_[k].second]/(s.sf->typeVolume()*NA) << " " << product_[k]/(e.sf->volume()*NA) << endl;
+  }
+  f.close();
+
+  f.open(reactionCountName_, ios::out|ios::app);
+  f << t;
+  for (auto c : n) f << " " << c;
+  for (auto c : fired_) f << " " << c;
+  f << endl;
+  f.close();
+}
+
+void WellMixed::runNRM() {
+  cout << blu << "[WellMixed] next reaction method" << def << endl;
+  openCount("nrm");
+
+  vector<long> n;
+  for (auto& s : slist_) n.push_back(s.n0);
+
+  // reactions to update after each reaction
+  vector<vector<size_t>> dep(rlist_.size());
+  for (size_t j=0; j < rlist_.size(); ++j)
+    for (size_t i=0; i < rlist_.size(); ++i) {
+      bool d = false;
+      for (auto& c : rlist_[j].change)
+        if (find(rlist_[i].reactant.begin(), rlist_[i].reactant.end(), c.first) != rlist_[i].reactant.end()) d = true;
+      if (d or (i == j)) dep[j].push_back(i);
+    }
+
+  const double inf = numeric_limits<double>::infinity();
+  vector<double> a(rlist_.size());
+  vector<double> tau(rlist_.size());
+  for (size_t j=0; j < rlist_.size(); ++j) {
+    a[j] = propensity(rlist_[j], n, V_);
+    tau[j] = (a[j] > 0.0) ? gsl_ran_exponential(rs_, 1.0/a[j]) : inf;
+  }
+  IndexedHeap heap;
+  heap.init(tau);
+
+  double t = 0.0, tnext = tout_;
+  size_t events = 0;
+  while (true) {
+    size_t j = heap.top();
+    double tj = heap.time(j);
+    // output up to next event
+    while ((tnext <= tj) and (tnext <= tmax_ + 0.5*tout_)) { writeCount(tnext, n); tnext += tout_; }
+    if ((tj > tmax_) or (tj == inf)) break;
+
+    t = tj;
+    fire(j, n);
+    events++;
+    for (auto i : dep[j]) {
+      double anew = propensity(rlist_[i], n, V_);
+      double tnew;
+      if (i == j)
+        tnew = (anew > 0.0) ? t + gsl_ran_exponential(rs_, 1.0/anew) : inf;
+      else if (anew == 0.0)
+        tnew = inf;
+      else if ((a[i] > 0.0) and (heap.time(i) < inf))
+        tnew = t + (a[i]/anew)*(heap.time(i) - t);      // reuse random number
+      else
+        tnew = t + gsl_ran_exponential(rs_, 1.0/anew);
+      a[i] = anew;
+      heap.update(i, tnew);
+    }
+  }
+  while (tnext <= tmax_ + 0.5*tout_) { writeCount(tnext, n); tnext += tout_; }
+
+  cout << "... events: " << gre << events << def << endl;
+  for (size_t k=0; k < pairs_.size(); ++k)
+    cout << "Product Rate " << slist_[pairs_[k].first].name << ": " << red
+         << product_[k]/(slist_[pairs_[k].first].sf->volume()*GSL_CONST_NUM_AVOGADRO*1e-21)/tmax_ << def << " [uM/s]" << endl;
+  cout << "... write " << countName_ << ", " << reactionCountName_ << endl;
+}
+
+void WellMixed::runRDME() {
+  cout << blu << "[WellMixed] next subvolume method" << def << endl;
+  openCount("rdme");
+
+  // inside voxels of the first species surface
+  Surfaces* sf = slist_[0].sf;
+  Vec3<double> lo = sf->minDimension();
+  Vec3<double> ext = sf->maxDimension() - lo;
+  long nx = max(1L, (long)ceil(ext.X()/h_));
+  long ny = max(1L, (long)ceil(ext.Y()/h_));
+  long nz = max(1L, (long)ceil(ext.Z()/h_));
+  vector<long> index(nx*ny*nz, -1);
+  vector<Vec3<double>> center;
+  for (long iz=0; iz < nz; ++iz)
+    for (long iy=0; iy < ny; ++iy)
+      for (long ix=0; ix < nx; ++ix) {
+        Vec3<double> c{lo.X()+(ix+0.5)*h_, lo.Y()+(iy+0.5)*h_, lo.Z()+(iz+0.5)*h_};
+        if (sf->isInside(c)) { index[(iz*ny + iy)*nx + ix] = center.size(); center.push_back(c); }
+      }
+  size_t nv = center.size();
+  if (nv == 0) {
+    cerr << "... no voxel inside surface with voxel size " << h_ << " [um]" << endl;
+    exit(1);
+  }
+  double hv = h_*h_*h_;
+  cout << "... cal Voxel Number: " << gre << nv << def << " (" << nx << "x" << ny << "x" << nz << ")" << endl;
+
+  // inside neighbors
+  vector<vector<size_t>> nb(nv);
+  for (long iz=0; iz < nz; ++iz)
+    for (long iy=0; iy < ny; ++iy)
+      for (long ix=0; ix < nx; ++ix) {
+        long v = index[(iz*ny + iy)*nx + ix];
+        if (v < 0) continue;
+        long d[6][3] = {{-1,0,0}, {1,0,0}, {0,-1,0}, {0,1,0}, {0,0,-1}, {0,0,1}};
+        for (auto& o : d) {
+          long jx = ix+o[0], jy = iy+o[1], jz = iz+o[2];
+          if ((jx < 0) or (jy < 0) or (jz < 0) or (jx >= nx) or (jy >= ny) or (jz >= nz)) continue;
+          long w = index[(jz*ny + jy)*nx + jx];
+          if (w >= 0) nb[v].push_back(w);
+        }
+      }
+
+  // uniform random placement
+  size_t ns = slist_.size();
+  vector<vector<long>> n(nv, vector<long>(ns, 0));
+  vector<long> total(ns, 0);
+  for (size_t s=0; s < ns; ++s) {
+    for (long k=0; k < slist_[s].n0; ++k) n[gsl_rng_uniform_int(rs_, nv)][s]++;
+    total[s] = slist_[s].n0;
+  }
+
+  // voxel rates: reactions + diffusion
+  auto rate = [&](size_t v, vector<double>& ar, double& ad) {
+    double sum = 0.0;
+    for (size_t j=0; j < rlist_.size(); ++j) { ar[j] = propensity(rlist_[j], n[v], hv); sum += ar[j]; }
+    ad = 0.0;
+    for (size_t s=0; s < ns; ++s) ad += slist_[s].D/(h_*h_)*n[v][s]*nb[v].size();
+    return sum + ad;
+  };
+  const double inf = numeric_limits<double>::infinity();
+  vector<double> ar(rlist_.size());
+  double ad;
+  vector<double> tv(nv);
+  for (size_t v=0; v < nv; ++v) {
+    double r = rate(v, ar, ad);
+    tv[v] = (r > 0.0) ? gsl_ran_exponential(rs_, 1.0/r) : inf;
+  }
+  IndexedHeap heap;
+  heap.init(tv);
+
+  double t = 0.0, tnext = tout_;
+  size_t events = 0, jumps = 0;
+  auto reschedule = [&](size_t v) {
+    double r = rate(v, ar, ad);
+    heap.update(v, (r > 0.0) ? t + gsl_ran_exponential(rs_, 1.0/r) : inf);
+  };
+
+  while (true) {
+    size_t v = heap.top();
+    double tj = heap.time(v);
+    while ((tnext <= tj) and (tnext <= tmax_ + 0.5*tout_)) { writeCount(tnext, total); tnext += tout_; }
+    if ((tj > tmax_) or (tj == inf)) break;
+    t = tj;
+
+    double r = rate(v, ar, ad);
+    double u = gsl_rng_uniform(rs_)*r;
+    if (u < r - ad) {
+      // reaction in voxel - rounding never ends the pick on a zero propensity
+      size_t last = rlist_.size()-1;
+      while (ar[last] <= 0.0) --last;
+      size_t j = 0;
+      while ((j < last) and (u >= ar[j])) { u -= ar[j]; ++j; }
+      fire(j, n[v]);
+      for (auto& c : rlist_[j].change) total[c.first] += c.second;
+      events++;
+      reschedule(v);
+    } else {
+      // jump of one molecule to a neighbor
+      // species with molecules that move - rounding never ends on an empty one
+      u -= r - ad;
+      size_t last = ns-1;
+      while ((slist_[last].D <= 0.0) or (n[v][last] <= 0)) --last;
+      size_t s = 0;
+      for (s=0; s < last; ++s) {
+        double as = slist_[s].D/(h_*h_)*n[v][s]*nb[v].size();
+        if (u < as) break;
+        u -= as;
+      }
+      size_t w = nb[v][gsl_rng_uniform_int(rs_, nb[v].size())];
+      n[v][s]--;
+      n[w][s]++;
+      jumps++;
+      reschedule(v);
+      reschedule(w);
+    }
+  }
+  while (tnext <= tmax_ + 0.5*tout_) { writeCount(tnext, total); tnext += tout_; }
+
+  cout << "... events: " << gre << events << def << " jumps: " << gre << jumps << def << endl;
+  for (size_t k=0; k < pairs_.size(); ++k)
+    cout << "Product Rate " << slist_[pairs_[k].first].name << ": " << red
+         << product_[k]/(slist_[pairs_[k].first].sf->volume()*GSL_CONST_NUM_AVOGADRO*1e-21)/tmax_ << def << " [uM/s]" << endl;
+  cout << "... write " << countName_ << ", " << reactionCountName_ << endl;
+}
+
+#endif
+
+// vim:foldmethod=syntax:foldlevel=0
@@ -30,6 +30,21 @@ void ParameterReader::save(string fn) {
   }
 }
 
+void ParameterReader::set(string name, string value, string selector) {
+    // same line as stringRead finds, else a new line
+    for (size_t i=0; i<lines_.size(); i++) {
+      if (lines_[i].find("#") == 0) continue;
+
+      auto found = lines_[i].find(name);
+      if (found == string::npos) continue;
+      auto found_selector = lines_[i].find(selector, found+1);
+      if (found_selector == string::npos) continue;
+      lines_[i] = lines_[i].substr(0, found_selector+1) + " " + value;
+      return;
+    }
+    lines_.push_back(name + selector + " " + value);
+}
+
 bool ParameterReader::checkName(string name, string selector) {
     for (size_t i=0; i<lines_.size(); i++) {
       // check comment lines
@@ -40,8 +40,10 @@ int ProgressBar::GetConsoleWidth(){
 		GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &csbi);
 		width = csbi.srWindow.Right - csbi.srWindow.Left;
 	#else
-		struct winsize win;
-		ioctl(0, TIOCGWINSZ, &win);
+		// no terminal (batch jobs, redirected output): fixed width
+		struct winsize win = {};
+		if ((ioctl(2, TIOCGWINSZ, &win) != 0) || (win.ws_col == 0))
+			win.ws_col = 80;
         width = win.ws_col;
 	#endif
 
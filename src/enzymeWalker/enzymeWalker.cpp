@@ -11,11 +11,16 @@
 // date: 20170907 version: 1.4.0 update: multiple cloud objects
 // date: 20170911 version: 1.5.0 update: change base library
 // date: 20170924 version: 1.6.0 update: fine tuning for diffusion case
+// date: 20261018 - population of cells in one run
+// date: 20261018 - parameter sweep with common random numbers
+// date: 20261019 - population and sweep do not combine
 
 #include "../base/include/Simulator.hpp"
 #include "../base/include/Log.hpp"
 #include "../base/include/ParameterReader.h"
 #include "../base/include/CloudCell.hpp"
+#include "../base/include/Population.hpp"
+#include "../base/include/Sweep.hpp"
 
 int main(int argc, char* argv[])
 {
@@ -38,6 +43,31 @@ int main(int argc, char* argv[])
   Log simLog{"cloud_log.txt", parname};
   ParameterReader pr{parname};
 
+  bool population = (pr.intRead("population Cells", "1", false) > 1);
+  bool sweep = (pr.stringRead("sweep Key", "", false) != "");
+  if (population and sweep) {
+    cerr << "... population Cells > 1 and sweep Key cannot be used together" << endl;
+    exit(1);
+  }
+
+  // many cells with drawn dimensions
+  if (population) {
+    Population p{pr, &simLog};
+    p.injectCells(pr);
+    cout << blu << "[Population] start simulation" << def << endl;
+    p.run();
+    return 0;
+  }
+
+  // one parameter over several values, same random numbers at every value
+  if (sweep) {
+    Sweep sw{pr, &simLog};
+    sw.injectPoints(pr);
+    cout << blu << "[Sweep] start simulation" << def << endl;
+    sw.run();
+    return 0;
+  }
+
   // create cell cloud object
   Simulator s{pr, &simLog};
   s.injectClouds(pr);
@@ -0,0 +1,102 @@
+// ptSlice.cpp
+//
+// slice columnar trajectory files (.ptc) by time range, cloud and tid
+//
+// author: sungcheolkim @ IBM
+//
+// date: 20261018 version: 1.0.0
+// date: 20261018 version: 1.1.0 update: compressed output
+
+#include "../base/include/Trajectory.hpp"
+#include <stdlib.h>
+#include <limits>
+
+void usage() {
+  cerr << "Usage: ptSlice [-l] [-t t0 t1] [-c cloud] [-i tid0 tid1] [-o out.pt|out.ptc] [-z res] file.ptc ..." << endl;
+  cerr << "  -l  show frames and time range of each file" << endl;
+  cerr << "  -t  frames with t0 <= t <= t1" << endl;
+  cerr << "  -c  files of this cloud only" << endl;
+  cerr << "  -i  walkers with tid0 <= tid <= tid1" << endl;
+  cerr << "  -o  text (.pt, default stdout) or columnar (.ptc, one cloud) output" << endl;
+  cerr << "  -z  compressed .ptc with position resolution res [nm]" << endl;
+  exit(0);
+}
+
+int main(int argc, char* argv[])
+{
+  double t0 = -numeric_limits<double>::infinity();
+  double t1 = numeric_limits<double>::infinity();
+  size_t tid0 = 0;
+  size_t tid1 = numeric_limits<size_t>::max();
+  string cloud {""};
+  string outname {""};
+  double resolution = 0.0;
+  bool list = false;
+  vector<string> files;
+
+  for (int i=1; i < argc; ++i) {
+    string a = argv[i];
+    if ((a == "-t") and (i+2 < argc)) { t0 = atof(argv[i+1]); t1 = atof(argv[i+2]); i += 2; }
+    else if ((a == "-i") and (i+2 < argc)) { tid0 = atol(argv[i+1]); tid1 = atol(argv[i+2]); i += 2; }
+    else if ((a == "-c") and (i+1 < argc)) { cloud = argv[++i]; }
+    else if ((a == "-o") and (i+1 < argc)) { outname = argv[++i]; }
+    else if ((a == "-z") and (i+1 < argc)) { resolution = atof(argv[++i])/1000.0; }
+    else if (a == "-l") { list = true; }
+    else if (a[0] == '-') { usage(); }
+    else files.push_back(a);
+  }
+  if (files.empty()) usage();
+
+  // output: text to stdout or file, or columnar file
+  bool columnar = (outname.find(".ptc") != string::npos);
+  ofstream outfile;
+  if (!outname.empty() and !columnar) outfile.open(outname.c_str());
+  ostream& out = (outname.empty() or columnar) ? cout : outfile;
+  TrajectoryWriter* tw = nullptr;
+  if (!list and !columnar) out << "t x y z r duration tid pid" << endl;
+
+  for (auto fn : files) {
+    TrajectoryReader tr{fn};
+    if (!cloud.empty() and (tr.cloudID() != cloud)) continue;
+
+    if (list) {
+      cout << fn << ": cloud " << tr.cloudID() << " r " << tr.r() << " frames " << tr.frames();
+      if (tr.frames() > 0)
+        cout << " t " << tr.index(0).t << " - " << tr.index(tr.frames()-1).t
+             << " walkers " << tr.index(tr.frames()-1).n;
+      if (tr.compressed())
+        cout << " compressed " << tr.resolution()*1000.0 << " [nm] chunk " << tr.chunk();
+      cout << (tr.indexed() ? "" : " (no index)") << endl;
+      continue;
+    }
+
+    if (columnar) {
+      if (tw != nullptr) {
+        cerr << "... columnar output takes one cloud, use -c" << endl;
+        exit(1);
+      }
+      tw = new TrajectoryWriter{outname, tr.cloudID(), tr.r(), resolution};
+    }
+
+    // seek first frame, then stop after t1
+    for (size_t i=tr.findTime(t0); i < tr.frames(); ++i) {
+      TrajectoryFrame f = tr.frame(i);
+      if (f.t > t1) break;
+
+      if (tw != nullptr) tw->beginFrame(f.t, f.step);
+      for (size_t k=0; k < f.n; ++k) {
+        if ((f.tid[k] < tid0) or (f.tid[k] > tid1)) continue;
+        if (tw != nullptr)
+          tw->add(Vec3<double>{f.x[k], f.y[k], f.z[k]}, f.duration[k], f.tid[k], f.pid[k]);
+        else
+          out << f.t << " " << f.x[k] << " " << f.y[k] << " " << f.z[k] << " " << tr.r()
+              << " " << f.duration[k] << " " << f.tid[k] << " " << (int)f.pid[k] << "\n";
+      }
+      if (tw != nullptr) tw->endFrame();
+    }
+  }
+
+  if (tw != nullptr) delete tw;
+}
+
+// vim:foldmethod=syntax:foldlevel=1
@@ -0,0 +1,58 @@
+// wellMixed.cpp
+//
+// stochastic reference solver (NRM, RDME) using the enzymeWalker parameter file
+//
+// author: sungcheolkim @ IBM
+//
+// date: 20261018 version: 1.0.0
+// date: 20261019 - seed from parameter file
+
+#include "../base/include/WellMixed.hpp"
+#include "../base/include/ParameterReader.h"
+#include <sys/time.h>
+
+int main(int argc, char* argv[])
+{
+  // prepare parameter file
+
+  string parname {"test.par"};
+  string method {"nrm"};
+  cout << blu << "[wellMixed] Well-mixed Reference Solver, version 1.0.0" << def << endl;
+
+  if (argc >= 2)
+    parname = argv[1];
+  if (argc >= 3)
+    method = argv[2];
+
+  ifstream f(parname.c_str());
+  if ( !f.good() or ((method != "nrm") and (method != "rdme")) ) {
+    cerr << "... no " << parname << " or unknown method " << method << endl;
+    cerr << "Usage: wellMixed [sim.par] [nrm|rdme]" << endl;
+    exit(0);
+  }
+
+  // read parameter file
+  ParameterReader pr{parname};
+
+  // seed: 0 - from clock
+  unsigned long int seed = stoul(pr.stringRead("seed", "0"));
+  if (seed == 0) {
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    seed = tv.tv_sec+tv.tv_usec;
+  }
+  gsl_rng_env_setup();
+  gsl_rng* rs = gsl_rng_alloc(gsl_rng_default);
+  gsl_rng_set(rs, seed);
+  cout << "... seed: " << seed << endl;
+
+  {
+    WellMixed wm{pr, rs};
+    if (method == "rdme") wm.runRDME();
+    else wm.runNRM();
+  }
+
+  gsl_rng_free(rs);
+}
+
+// vim:foldmethod=syntax:foldlevel=1
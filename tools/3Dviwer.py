@@ -6,6 +6,7 @@ particle trajectory viewer using glumpy
 
 Date: 20170814 - update for key input
 Date: 20170904 - update for input argument, cleanup using collection-point
+Date: 20261018 - read columnar trajectory (.ptc)
 """
 
 import sys
@@ -15,7 +16,7 @@ from glumpy.graphics.collections import PointCollection, SegmentCollection
 from glumpy.ext import png
 from glumpy.transforms import Trackball, Position
 from glumpy.app.movie import record
-import ptlib._pt_utils as utils
+from ptcReader import readTrajectory
 
 __author__ = 'Sung-Cheol Kim'
 __version__ = '1.1.0'
@@ -29,7 +30,7 @@ def reset(t):
 
 def addData(fn, points, color=(0, 0, 0, -1)):
     try:
-        ndata = utils.readPTFile(fn)
+        ndata = readTrajectory(fn)
     except:
         print("... error reading file: {}".format(fn))
         exit(1)
@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+"""
+densityMap.py
+
+read density maps (<name>_<cloud>_map.bin, "<cloud> Density Map: True") and
+plot the projections of occupancy, reaction and wall hit maps
+
+Date: 20261018 - initial version
+"""
+
+import sys
+import struct
+import numpy as np
+
+__author__ = 'Sung-Cheol Kim'
+__version__ = '1.0.0'
+
+HEADER = struct.Struct('<8s4I3dddQ')
+NAMES = ('occupancy', 'reaction', 'wall')
+
+
+def readMap(fn):
+    """ dict with grid, 3d maps [z, y, x] and projections xy [y, x], xz [z, x], yz [z, y] """
+    buf = open(fn, 'rb').read()
+    magic, nx, ny, nz, maps, lx, ly, lz, h, t, samples = HEADER.unpack_from(buf, 0)
+    if magic != b'LEVYMAP1':
+        raise ValueError('... not a density map: {}'.format(fn))
+
+    res = {'lo': (lx, ly, lz), 'h': h, 't': t, 'samples': samples, 'shape': (nz, ny, nx)}
+    n = nx*ny*nz
+    data = np.frombuffer(buf, dtype='<u8', offset=HEADER.size)
+    for k in range(maps):
+        res[NAMES[k]] = data[k*n:(k+1)*n].reshape(nz, ny, nx)
+    p = maps*n
+    for k in range(maps):
+        res[NAMES[k] + '_xy'] = data[p:p+nx*ny].reshape(ny, nx)
+        p += nx*ny
+        res[NAMES[k] + '_xz'] = data[p:p+nx*nz].reshape(nz, nx)
+        p += nx*nz
+        res[NAMES[k] + '_yz'] = data[p:p+ny*nz].reshape(nz, ny)
+        p += ny*nz
+    return res
+
+
+def plotMap(fn, name='occupancy'):
+    import matplotlib
+    matplotlib.use('Agg')
+    import matplotlib.pyplot as plt
+
+    m = readMap(fn)
+    lx, ly, lz = m['lo']
+    nz, ny, nx = m['shape']
+    h = m['h']
+    ext = {'xy': [lx, lx+nx*h, ly, ly+ny*h], 'xz': [lx, lx+nx*h, lz, lz+nz*h], 'yz': [ly, ly+ny*h, lz, lz+nz*h]}
+
+    fig, axs = plt.subplots(1, 3, figsize=(15, 4))
+    for ax, pl in zip(axs, ('xy', 'xz', 'yz')):
+        ax.imshow(m[name + '_' + pl], origin='lower', extent=ext[pl], aspect='equal')
+        ax.set_xlabel(pl[0] + ' [um]')
+        ax.set_ylabel(pl[1] + ' [um]')
+    axs[0].set_title('{} t={:.3f} [s] samples={}'.format(name, m['t'], m['samples']))
+    out = fn.replace('.bin', '_{}.pdf'.format(name))
+    fig.savefig(out)
+    print('... save {}'.format(out))
+
+
+if __name__ == '__main__':
+    if len(sys.argv) < 2:
+        print('Usage: densityMap.py <name>_<cloud>_map.bin [occupancy|reaction|wall]')
+        exit(0)
+    plotMap(sys.argv[1], sys.argv[2] if len(sys.argv) > 2 else 'occupancy')
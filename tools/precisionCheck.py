@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+"""
+precisionCheck.py
+
+compare the float position build (enzymeWalker_sp, cmake -DSINGLE_PRECISION=ON)
+with the double build: both run the same parameter file for a set of seeds,
+and the summary values (product, rate, wall hits, free path) are compared by
+their mean over seeds. a difference is flagged when it is larger than
+3 standard errors of the difference; single runs differ anyway since one
+rounding changes the random path.
+
+Date: 20261018 - initial version
+"""
+
+import os
+import re
+import sys
+import time
+import tempfile
+import subprocess
+import numpy as np
+
+__author__ = 'Sung-Cheol Kim'
+__version__ = '1.0.0'
+
+ANSI = re.compile(r'\x1b\[[0-9;]*m')
+VALUES = {'Total Product': r'^Total Product: (\S+)',
+          'Steady Rate': r'^Steady Rate: (\S+)',
+          'Wall Hit': r'^Wall Hit: (\S+)',
+          'Mean Free Time': r'^Mean Free Time: (\S+)',
+          'Mean Free Length': r'^Mean Free Length: (\S+)'}
+
+
+def runOnce(exe, par, seed):
+    """ summary values and wall time of one run with the given seed """
+    lines = [l for l in open(par) if not l.startswith('seed')]
+    lines.append('seed: {}\n'.format(seed))
+    with tempfile.NamedTemporaryFile('w', suffix='.par', dir='.', delete=False) as f:
+        f.writelines(lines)
+        fn = f.name
+    t0 = time.time()
+    out = subprocess.run([exe, fn], stdout=subprocess.PIPE, stderr=subprocess.DEVNULL).stdout
+    sec = time.time() - t0
+    os.remove(fn)
+
+    text = ANSI.sub('', out.decode(errors='replace'))
+    res = {'sec': sec}
+    for k, pat in VALUES.items():
+        m = re.search(pat, text, re.M)
+        if m:
+            res[k] = float(m.group(1))
+    return res
+
+
+def compare(par, seeds=8, exe='enzymeWalker', exeSP='enzymeWalker_sp'):
+    runs = {exe: [], exeSP: []}
+    for s in range(1, seeds+1):
+        for e in runs:
+            runs[e].append(runOnce(e, par, s))
+        print('... seed {} done'.format(s))
+
+    print('{:18s} {:>14s} {:>14s} {:>10s} {:>8s}'.format('', 'double', 'float', 'diff [%]', 'z'))
+    for k in list(VALUES) + ['sec']:
+        a = np.array([r[k] for r in runs[exe] if k in r])
+        b = np.array([r[k] for r in runs[exeSP] if k in r])
+        if len(a) < 2 or len(b) < 2:
+            continue
+        ea, eb = a.std(ddof=1)/np.sqrt(len(a)), b.std(ddof=1)/np.sqrt(len(b))
+        diff = b.mean() - a.mean()
+        z = diff/np.sqrt(ea**2 + eb**2) if ea + eb > 0 else 0.0
+        flag = '' if (k == 'sec' or abs(z) < 3.0) else ' <- differs'
+        print('{:18s} {:>14.6g} {:>14.6g} {:>10.3f} {:>8.2f}{}'.format(
+            k, a.mean(), b.mean(), 100.0*diff/a.mean() if a.mean() != 0 else 0.0, z, flag))
+
+
+if __name__ == '__main__':
+    if len(sys.argv) < 2:
+        print('Usage: precisionCheck.py <file.par> [seeds] [double exe] [float exe]')
+        exit(0)
+    compare(sys.argv[1], int(sys.argv[2]) if len(sys.argv) > 2 else 8, *sys.argv[3:5])
@@ -0,0 +1,217 @@
+#!/usr/bin/env python3
+"""
+ptcReader.py
+
+reader for columnar trajectory files (.ptc) written with "save Format: Column"
+
+the file is mapped once; frame(i) returns numpy views into the map (no copy)
+and findTime(t) finds a frame from the index table. readPTCFile returns the
+same record array as ptlib readPTFile for the text (.pt) files. compressed
+files ("save Format: Compressed") are decoded from the key frame of the chunk,
+so their frames are copies.
+
+Date: 20261018 - initial version
+Date: 20261018 - compressed frames
+"""
+
+import sys
+import mmap
+import struct
+import numpy as np
+
+__author__ = 'Sung-Cheol Kim'
+__version__ = '1.0.0'
+
+HEADER = struct.Struct('<8sII d 32s Q')
+COLUMN = struct.Struct('<12s4s')
+CODEC = struct.Struct('<dII')
+FRAME = np.dtype([('t', '<f8'), ('step', '<u8'), ('n', '<u8'), ('bytes', '<u8')])
+INDEX = np.dtype([('t', '<f8'), ('step', '<u8'), ('n', '<u8'), ('offset', '<u8')])
+TRAILER = struct.Struct('<QQ8s')
+
+
+def _pad(n):
+    return (n + 7)//8*8
+
+
+def _varint(buf, p):
+    v, s = 0, 0
+    while True:
+        b = buf[p]
+        p += 1
+        v |= (b & 0x7f) << s
+        if b < 0x80:
+            return v, p
+        s += 7
+
+
+def _packed(buf, p, n):
+    """ zigzag codes of one packed column """
+    base, p = _varint(buf, p)
+    w = buf[p]
+    p += 1
+    if w == 0:
+        return np.full(n, base, dtype=np.uint64), p
+    nb = (n*w + 7)//8
+    bits = np.unpackbits(np.frombuffer(buf, np.uint8, nb, p), bitorder='little')[:n*w].reshape(n, w)
+    v = (bits.astype(np.uint64) << np.arange(w, dtype=np.uint64)).sum(axis=1, dtype=np.uint64)
+    return v + np.uint64(base), p + nb
+
+
+def _unzigzag(u):
+    return (u >> np.uint64(1)).astype(np.int64) ^ -(u & np.uint64(1)).astype(np.int64)
+
+
+class PTCFile(object):
+    """ mapped .ptc file """
+
+    def __init__(self, fn):
+        with open(fn, 'rb') as f:
+            self.mm = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+
+        magic, version, ncol, self.r, cid, self.headerSize = HEADER.unpack_from(self.mm, 0)
+        if magic != b'LEVYPTC1':
+            raise ValueError('... not a trajectory file: {}'.format(fn))
+        self.cloudID = cid.rstrip(b'\0').decode()
+
+        self.columns = []
+        for k in range(ncol):
+            name, dtype = COLUMN.unpack_from(self.mm, HEADER.size + k*COLUMN.size)
+            self.columns.append((name.rstrip(b'\0').decode(), np.dtype(dtype.rstrip(b'\0').decode())))
+
+        self.resolution, self.chunk = 0.0, 1
+        if version == 2:
+            self.resolution, self.chunk, _ = CODEC.unpack_from(self.mm, HEADER.size + ncol*COLUMN.size)
+        self.decoded = -1
+
+        self.index = self._readIndex()
+
+    def compressed(self):
+        return self.resolution > 0.0
+
+    def _frameBytes(self, n):
+        return FRAME.itemsize + sum(_pad(n*dt.itemsize) for _, dt in self.columns)
+
+    def _readIndex(self):
+        size = len(self.mm)
+        if size >= self.headerSize + TRAILER.size:
+            offset, frames, magic = TRAILER.unpack_from(self.mm, size - TRAILER.size)
+            if magic == b'PTCINDEX' and offset + frames*INDEX.itemsize + TRAILER.size == size:
+                return np.frombuffer(self.mm, dtype=INDEX, count=frames, offset=offset)
+
+        # no trailer - walk frame headers
+        print('... no frame index, scan frames')
+        rows = []
+        offset = self.headerSize
+        while offset + FRAME.itemsize <= size:
+            fh = np.frombuffer(self.mm, dtype=FRAME, count=1, offset=offset)[0]
+            if self.compressed():
+                sized = fh['bytes'] > FRAME.itemsize and fh['bytes'] % 8 == 0
+            else:
+                sized = fh['bytes'] == self._frameBytes(int(fh['n']))
+            if not sized or offset + fh['bytes'] > size:
+                break
+            rows.append((fh['t'], fh['step'], fh['n'], offset))
+            offset += int(fh['bytes'])
+        return np.array(rows, dtype=INDEX)
+
+    def __len__(self):
+        return len(self.index)
+
+    def times(self):
+        return self.index['t']
+
+    def findTime(self, t):
+        """ first frame at or after t """
+        return int(np.searchsorted(self.index['t'], t, side='left'))
+
+    def _decode(self, i):
+        n = int(self.index['n'][i])
+        p = int(self.index['offset'][i]) + FRAME.itemsize
+        if i % self.chunk == 0:
+            self.q = np.zeros((4, 0), dtype=np.int64)
+
+        zz, p = _packed(self.mm, p, n)
+        tid = np.cumsum(_unzigzag(zz)) - 1
+        m = int(tid.max()) + 1 if n > 0 else 0
+        if m > self.q.shape[1]:
+            self.q = np.hstack((self.q, np.zeros((4, m - self.q.shape[1]), dtype=np.int64)))
+
+        cols = {'t': self.index['t'][i], 'tid': tid.astype(np.uint32)}
+        for a, name in enumerate(('x', 'y', 'z')):
+            zz, p = _packed(self.mm, p, n)
+            self.q[a, tid] += _unzigzag(zz)
+            cols[name] = self.q[a, tid]*self.resolution
+        zz, p = _packed(self.mm, p, n)
+        self.q[3, tid] = (self.q[3, tid] + _unzigzag(zz)) & 0xff
+        cols['pid'] = self.q[3, tid].astype(np.uint8)
+
+        duration = np.zeros(n)
+        count, p = _varint(self.mm, p)
+        k = 0
+        for j in range(count):
+            gap, p = _varint(self.mm, p)
+            k += gap
+            duration[k] = struct.unpack_from('<d', self.mm, p)[0]
+            p += 8
+        cols['duration'] = duration
+
+        self.decoded = i
+        self.cols = cols
+
+    def frame(self, i):
+        """ dict of column views of frame i """
+        if self.compressed():
+            # continue in the same chunk or start at the key frame
+            key = i - i % self.chunk
+            start = self.decoded + 1 if key <= self.decoded <= i else key
+            for j in range(start, i + 1):
+                self._decode(j)
+            return dict(self.cols)
+
+        n = int(self.index['n'][i])
+        offset = int(self.index['offset'][i]) + FRAME.itemsize
+        cols = {'t': self.index['t'][i]}
+        for name, dt in self.columns:
+            cols[name] = np.frombuffer(self.mm, dtype=dt, count=n, offset=offset)
+            offset += _pad(n*dt.itemsize)
+        return cols
+
+
+def readPTCFile(fn, t0=-np.inf, t1=np.inf):
+    """ record array (t, x, y, z, r, duration, tid, pid) of frames in [t0, t1] """
+    pf = PTCFile(fn)
+    i0 = pf.findTime(t0)
+    i1 = int(np.searchsorted(pf.index['t'], t1, side='right'))
+    n = int(pf.index['n'][i0:i1].sum())
+
+    dtype = [('t', 'f8'), ('x', 'f8'), ('y', 'f8'), ('z', 'f8'), ('r', 'f8'),
+             ('duration', 'f8'), ('tid', 'i8'), ('pid', 'i8')]
+    ndata = np.zeros(n, dtype=dtype)
+    ndata['r'] = pf.r
+    k = 0
+    for i in range(i0, i1):
+        f = pf.frame(i)
+        m = len(f['x'])
+        for name in ndata.dtype.names:
+            if name in f:
+                ndata[name][k:k+m] = f[name]
+        k += m
+    return ndata
+
+
+def readTrajectory(fn):
+    """ .ptc with this reader, text .pt with ptlib """
+    if fn.endswith('.ptc'):
+        return readPTCFile(fn)
+    import ptlib._pt_utils as utils
+    return utils.readPTFile(fn)
+
+
+if __name__ == '__main__':
+    for fn in sys.argv[1:]:
+        pf = PTCFile(fn)
+        t = pf.times()
+        print('{}: cloud {} r {} frames {} t {} - {}{}'.format(fn, pf.cloudID, pf.r, len(pf),
+              t[0] if len(t) else '-', t[-1] if len(t) else '-',
+              ' compressed {} [nm]'.format(pf.resolution*1000) if pf.compressed() else ''))
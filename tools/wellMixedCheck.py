@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+"""
+wellMixedCheck.py
+
+compare the particle run (enzymeWalker) with the well-mixed reference
+(wellMixed nrm) on the same parameter file: both run for a set of seeds and
+the reaction counts in the last line of <name>_reaction_count.txt are
+compared by their mean over seeds. a difference is flagged when it is larger
+than 3 standard errors of the difference and than the relative tolerance:
+walls, one partner per walker and step and the memory of positions between
+steps are not in the well-mixed rate, so a few percent are expected. a
+larger difference means that the reactants do not fill the cell faster than
+they react (diffusion limited), where only the particle run is right.
+
+Date: 20261019 - initial version
+"""
+
+import os
+import sys
+import tempfile
+import subprocess
+import numpy as np
+
+__author__ = 'Sung-Cheol Kim'
+__version__ = '1.0.0'
+
+
+def lastCount(fn):
+    """ column names and values of the last line of a reaction count file """
+    lines = [l.split() for l in open(fn) if l.strip()]
+    return dict(zip(lines[0][1:], [float(x) for x in lines[-1]]))
+
+
+def runOnce(cmd, par, seed, suffix):
+    """ last reaction counts of one run with the given seed """
+    lines = [l for l in open(par) if not l.startswith('seed') and not l.startswith('show Progress')]
+    lines.append('seed: {}\n'.format(seed))
+    lines.append('show Progress: False\n')
+    with tempfile.NamedTemporaryFile('w', suffix='.par', dir='.', delete=False) as f:
+        f.writelines(lines)
+        fn = f.name
+    subprocess.run(cmd + [fn], stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+
+    base = fn[:-4]
+    res = lastCount(base + suffix)
+    for out in os.listdir('.'):
+        if out.startswith(os.path.basename(base)):
+            os.remove(out)
+    return res
+
+
+def ruleNames(par):
+    """ reaction table rules of the parameter file (reverse rules end with r) """
+    for l in open(par):
+        if l.startswith('reaction Names'):
+            names = [n.strip() for n in l.split(':', 1)[1].strip(' ()\n').split(',')]
+            return names + [n + 'r' for n in names]
+    return []
+
+
+def compare(par, seeds=4, exe='enzymeWalker', exeWM='wellMixed', tol=0.05):
+    rules = ruleNames(par)
+    runs = {'particle': [], 'nrm': []}
+    for s in range(1, seeds+1):
+        runs['particle'].append(runOnce([exe], par, s, '_reaction_count.txt'))
+        runs['nrm'].append(runOnce([exeWM], par, s, '_nrm_reaction_count.txt'))
+        print('... seed {} done'.format(s))
+
+    print('{:10s} {:>14s} {:>14s} {:>10s} {:>8s}'.format('', 'particle', 'nrm', 'diff [%]', 'z'))
+    for k in [k for k in runs['particle'][0] if k in rules]:
+        a = np.array([r[k] for r in runs['particle'] if k in r])
+        b = np.array([r[k] for r in runs['nrm'] if k in r])
+        if len(a) < 2 or len(b) < 2:
+            continue
+        ea, eb = a.std(ddof=1)/np.sqrt(len(a)), b.std(ddof=1)/np.sqrt(len(b))
+        diff = b.mean() - a.mean()
+        z = diff/np.sqrt(ea**2 + eb**2) if ea + eb > 0 else 0.0
+        rel = diff/a.mean() if a.mean() != 0 else 0.0
+        flag = ' <- differs' if (abs(z) > 3.0 and abs(rel) > tol) else ''
+        print('{:10s} {:>14.6g} {:>14.6g} {:>10.3f} {:>8.2f}{}'.format(
+            k, a.mean(), b.mean(), 100.0*rel, z, flag))
+
+
+if __name__ == '__main__':
+    if len(sys.argv) < 2:
+        print('Usage: wellMixedCheck.py <file.par> [seeds] [enzymeWalker exe] [wellMixed exe]')
+        exit(0)
+    compare(sys.argv[1], int(sys.argv[2]) if len(sys.argv) > 2 else 4, *sys.argv[3:5])